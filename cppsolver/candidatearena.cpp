@@ -0,0 +1,62 @@
+#include "candidatearena.hpp"
+#include "numatopology.hpp"
+#include "words.h"
+
+#include <cstring>
+#include <thread>
+#include <new>
+
+std::shared_ptr<const CandidateArena> CandidateArena::create(const void* mem, size_t size, bool hugePages) {
+    std::shared_ptr<CandidateArena> arena{ new CandidateArena() };
+    arena->bytes = size;
+
+    int nodes = numaNodeCount();
+    arena->replicas.resize(nodes);
+
+    for (int node = 0; node < nodes; node++) {
+        Replica& replica = arena->replicas[node];
+        replica.mem = allocateNodeMemory(size == 0 ? 1 : size, node, hugePages, replica.allocatedSize, replica.hugePages);
+        if (replica.mem == nullptr) throw std::bad_alloc();
+    }
+
+    if (nodes == 1) {
+        std::memcpy(arena->replicas[0].mem, mem, size);
+    }
+    else {
+        //first touch from a thread pinned to each node places the pages there
+        std::vector<std::thread> fillers;
+        for (int node = 0; node < nodes; node++) {
+            fillers.emplace_back([&arena, mem, size, node] {
+                pinCurrentThreadToNumaNode(node);
+                std::memcpy(arena->replicas[node].mem, mem, size);
+            });
+        }
+        for (std::thread& filler : fillers) filler.join();
+    }
+
+    return arena;
+}
+
+std::shared_ptr<const CandidateArena> CandidateArena::createStatic(const void* mem, size_t size, bool hugePages) {
+    if (numaNodeCount() > 1) return create(mem, size, hugePages);
+
+    std::shared_ptr<CandidateArena> arena{ new CandidateArena() };
+    arena->bytes = size;
+    arena->replicas.resize(1);
+    arena->replicas[0].mem = const_cast<void*>(mem);
+    arena->replicas[0].owned = false;
+    return arena;
+}
+
+CandidateArena::~CandidateArena() {
+    for (Replica& replica : this->replicas) {
+        if (replica.owned) freeNodeMemory(replica.mem, replica.allocatedSize);
+    }
+}
+
+bool CandidateArena::usesHugePages() const {
+    for (const Replica& replica : this->replicas) {
+        if (!replica.hugePages) return false;
+    }
+    return !this->replicas.empty();
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+// immutable copy of a packed candidate list shared by every pool worker
+// one replica per numa node, each filled from a thread on that node so its pages are local
+// freed when the last shared_ptr to it goes away, so a solve holds it only as long as it needs it
+class CandidateArena {
+public:
+    static std::shared_ptr<const CandidateArena> create(const void* mem, size_t size, bool hugePages);
+    // for memory that outlives the arena, like the embedded or loaded word tables
+    // on a single node every worker reads mem in place, otherwise it is replicated like create
+    static std::shared_ptr<const CandidateArena> createStatic(const void* mem, size_t size, bool hugePages);
+    ~CandidateArena();
+
+    CandidateArena(const CandidateArena&) = delete;
+    CandidateArena& operator=(const CandidateArena&) = delete;
+
+    // at least 64 byte aligned (page aligned in practice)
+    const void* nodeCopy(int node) const { return this->replicas[node].mem; }
+    int getNodeCount() const { return (int)this->replicas.size(); }
+    size_t size() const { return this->bytes; }
+    bool usesHugePages() const;
+
+private:
+    CandidateArena() = default;
+
+    struct Replica {
+        void* mem = nullptr;
+        size_t allocatedSize = 0;
+        bool hugePages = false;
+        bool owned = true;
+    };
+
+    std::vector<Replica> replicas;
+    size_t bytes = 0;
+};
@@ -7,135 +7,450 @@
 #include "words.h"
 
 #include "findnocommonchars.hpp"
+#include "feedbackpattern.hpp"
+#include "patternmatrix.hpp"
+#include "cpufeatures.hpp"
+#include "gamesession.hpp"
+#include "solver.hpp"
+#include "server.hpp"
+#include "wordlistfile.hpp"
+#include "strategytree.hpp"
+#include "openingbook.hpp"
+#include "multiboard.hpp"
+#include "selftest.hpp"
+
+int main(int argc, char** argv)
+{
+    // 
+    // NOTE BEFORE USE:
+    // NASM and the Visual Studio extension VSNASM is required to compile this project.
+    // Build in x64 mode ONLY, assembly uses the Windows x64 ABI
+    // SSE4.2 required, AVX2 and AVX-512 kernels are picked at runtime
+    //
+    // Options:
+    //   --kernel=scalar|sse42|avx2|avx512   force a kernel (default: fastest the cpu supports)
+    //   --scoring=filter|pattern|matrix     filter: one WordFilter pass per answer
+    //                                       pattern: bucket answers by feedback code
+    //                                       matrix: pattern, reading codes from patternmatrix.bin (default)
+    //   --matrix-max-mb=<n>                 largest pattern matrix to build or map (default 2048), larger word lists
+    //                                       score with the pattern kernels
+    //   --turn=<guess>:<digits>             narrow the answers with a played turn instead of the filter below,
+    //                                       digits are 0/1/2 (wrong/misplaced/correct) per letter as Wordle shows
+    //                                       them, so a repeated letter is misplaced only as often as the answer holds it,
+    //                                       repeatable
+    //   --boards=<n>                        play n boards at once (2 to 32), every --turn then gives one comma
+    //                                       separated digit group per board, e.g. --turn=roate:00120,20000
+    //                                       --metric=expected sums the boards' expected candidates, solve ranks by
+    //                                       the chance to solve any board
+    //   --metric=expected|entropy|worst|solve|solve2
+    //                                       ranking (default expected), anything but expected uses pattern scoring,
+    //                                       server requests pick theirs with metric=
+    //   --deadline=<seconds>                rank within a time budget, guesses are scored most promising first and the
+    //                                       best of those evaluated when it runs out are printed
+    //   --sample=<n>                        estimate expected or entropy from a stratified sample of n candidates, refining
+    //                                       only the guesses that can still make the list, for very large answer lists
+    //   --sample-max=<n>                    stop refining at n candidates sampled (default: until the values are exact)
+    //   --hard-mode                         only rank guesses consistent with the turns and filter so far
+    //   --lookahead=<n>                     rerank the n best guesses by expected guesses to solve, looking one
+    //                                       follow-up guess ahead for every feedback they can get
+    //   --lookahead-budget=<seconds>        stop expanding guesses after this long, the rest keep their metric order
+    //   --threads=<n>                       scoring threads (default: one per hardware thread)
+    //   --huge-pages                        back the shared candidate list with 2MB pages when the OS allows it
+    //   --serve                             answer line delimited requests from stdin until eof (see server.hpp)
+    //   --serve=unix:<path>                 answer requests on a unix domain socket
+    //   --build-tree=<path>                 write a strategy tree for every answer (ranked by --metric) and exit
+    //   --tree=<path>                       play the --turn guesses along a strategy tree and print its next guess
+    //   --build-book=<path>                 write an opening book (first turn and every second turn, ranked by --metric) and exit
+    //   --book=<path>                       answer first and second turns from an opening book instead of searching
+    //   --words=<path>                      guess list to load instead of the built in one,
+    //                                       a json array like Words.txt or one word per line
+    //   --answers=<path>                    answer list to load instead of the built in one, same formats
+    //   --self-test                         check the feedback codes, filters and kernels against each other and exit,
+    //                                       nonzero if any check failed
+    //
 
-/**
- * @brief Gets the original indexes of the smallest N numbers in a vector of floats.
- *
- * This function creates pairs of (value, original_index), sorts them based on value
- * in ascending order, and then extracts the indexes of the top N elements.
- *
- * @param vec The input vector of float numbers.
- * @param n The number of smallest elements to find indexes for.
- * @return A vector of integers, representing the original indexes of the smallest N numbers.
- *         The indexes are returned in the order of their corresponding values (smallest first).
- *         Returns an empty vector if n <= 0 or the input vector is empty.
- */
-std::vector<int> get_smallest_n_indexes(const std::vector<float>& vec, int n) {
-    // Handle edge cases: n is non-positive or vector is empty
-    if (n <= 0 || vec.empty()) {
-        return {};
+    CpuFeatures cpuFeatures = detectCpuFeatures();
+    SimdLevel simdLevel = bestSimdLevel(cpuFeatures);
+
+    // score guesses by bucketing answers on their feedback code (same results as the filter modes)
+    bool pattern_mode = true;
+    // read the codes from the allWords x validWords matrix file instead of computing them
+    bool pattern_matrix_mode = true;
+    const char* patternMatrixPath = "patternmatrix.bin";
+    size_t patternMatrixMaxBytes = PATTERN_MATRIX_DEFAULT_MAX_BYTES;
+    bool hugePages = false;
+    int threads = 0;
+    ScoringMetric metric = ScoringMetric::ExpectedSize;
+    //one feedback code per board
+    std::vector<std::pair<std::string, std::vector<unsigned char>>> turns;
+    int boards = 1;
+    LookaheadConfig lookahead;
+    bool lookaheadMode = false;
+    bool hardMode = false;
+    double deadline = 0.0;
+    SamplingConfig sampling;
+    bool sampledMode = false;
+    bool serve = false;
+    bool selfTest = false;
+    std::string socketPath;
+    std::string wordsPath;
+    std::string buildTreePath;
+    std::string treePath;
+    std::string buildBookPath;
+    std::string bookPath;
+    std::string answersPath;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--kernel=", 0) == 0) {
+            SimdLevel forced;
+            if (!parseSimdLevel(arg.substr(9), forced)) {
+                std::cout << "unknown kernel " << arg.substr(9) << "\n";
+                return 1;
+            }
+            if (!simdLevelSupported(cpuFeatures, forced)) {
+                std::cout << "kernel " << simdLevelName(forced) << " is not supported on this cpu\n";
+                return 1;
+            }
+            simdLevel = forced;
+        }
+        else if (arg == "--scoring=filter") {
+            pattern_mode = false;
+            pattern_matrix_mode = false;
+        }
+        else if (arg == "--scoring=pattern") {
+            pattern_mode = true;
+            pattern_matrix_mode = false;
+        }
+        else if (arg == "--scoring=matrix") {
+            pattern_mode = true;
+            pattern_matrix_mode = true;
+        }
+        else if (arg.rfind("--matrix-max-mb=", 0) == 0) {
+            long long megabytes = std::atoll(arg.c_str() + 16);
+            if (megabytes <= 0) {
+                std::cout << "matrix-max-mb must be a positive number of megabytes\n";
+                return 1;
+            }
+            patternMatrixMaxBytes = (size_t)megabytes << 20;
+        }
+        else if (arg.rfind("--metric=", 0) == 0) {
+            if (!parseScoringMetric(arg.substr(9), metric)) {
+                std::cout << "unknown metric " << arg.substr(9) << "\n";
+                return 1;
+            }
+        }
+        else if (arg.rfind("--turn=", 0) == 0) {
+            std::string turn = arg.substr(7);
+            std::string guess;
+            std::vector<unsigned char> codes;
+            bool valid = turn.size() >= 11 && turn[5] == ':' && readLetters(turn.substr(0, 5), guess);
+            for (size_t at = 6; valid && at < turn.size(); at += 6) {
+                unsigned char code;
+                valid = parseFeedbackPattern(turn.substr(at, 5), code) && (at + 5 == turn.size() || turn[at + 5] == ',');
+                codes.push_back(code);
+            }
+            if (!valid) {
+                std::cout << "turns look like --turn=roate:00120, or --turn=roate:00120,20000 with several boards\n";
+                return 1;
+            }
+            turns.emplace_back(guess, codes);
+        }
+        else if (arg.rfind("--boards=", 0) == 0) {
+            boards = std::atoi(arg.c_str() + 9);
+            if (boards < 1 || boards > MAX_BOARDS) {
+                std::cout << "boards must be between 1 and " << MAX_BOARDS << "\n";
+                return 1;
+            }
+        }
+        else if (arg.rfind("--lookahead=", 0) == 0) {
+            lookahead.firstGuesses = std::atoi(arg.c_str() + 12);
+            if (lookahead.firstGuesses <= 0) {
+                std::cout << "lookahead must be a positive number of guesses\n";
+                return 1;
+            }
+            lookaheadMode = true;
+        }
+        else if (arg.rfind("--lookahead-budget=", 0) == 0) {
+            lookahead.timeBudget = std::atof(arg.c_str() + 19);
+            if (lookahead.timeBudget <= 0) {
+                std::cout << "lookahead budget must be a positive number of seconds\n";
+                return 1;
+            }
+        }
+        else if (arg.rfind("--deadline=", 0) == 0) {
+            deadline = std::atof(arg.c_str() + 11);
+            if (deadline <= 0) {
+                std::cout << "deadline must be a positive number of seconds\n";
+                return 1;
+            }
+        }
+        else if (arg.rfind("--sample=", 0) == 0) {
+            long long sample = std::atoll(arg.c_str() + 9);
+            if (sample <= 0) {
+                std::cout << "sample must be a positive number of candidates\n";
+                return 1;
+            }
+            sampling.initialSample = (size_t)sample;
+            sampledMode = true;
+        }
+        else if (arg.rfind("--sample-max=", 0) == 0) {
+            long long sample = std::atoll(arg.c_str() + 13);
+            if (sample <= 0) {
+                std::cout << "sample-max must be a positive number of candidates\n";
+                return 1;
+            }
+            sampling.maxSample = (size_t)sample;
+        }
+        else if (arg == "--hard-mode") {
+            hardMode = true;
+        }
+        else if (arg.rfind("--threads=", 0) == 0) {
+            threads = std::atoi(arg.c_str() + 10);
+            if (threads <= 0) {
+                std::cout << "threads must be a positive number\n";
+                return 1;
+            }
+        }
+        else if (arg == "--huge-pages") {
+            hugePages = true;
+        }
+        else if (arg == "--self-test") {
+            selfTest = true;
+        }
+        else if (arg == "--serve") {
+            serve = true;
+        }
+        else if (arg.rfind("--serve=unix:", 0) == 0 && arg.size() > 13) {
+            serve = true;
+            socketPath = arg.substr(13);
+        }
+        else if (arg.rfind("--build-tree=", 0) == 0) {
+            buildTreePath = arg.substr(13);
+        }
+        else if (arg.rfind("--tree=", 0) == 0) {
+            treePath = arg.substr(7);
+        }
+        else if (arg.rfind("--build-book=", 0) == 0) {
+            buildBookPath = arg.substr(13);
+        }
+        else if (arg.rfind("--book=", 0) == 0) {
+            bookPath = arg.substr(7);
+        }
+        else if (arg.rfind("--words=", 0) == 0) {
+            wordsPath = arg.substr(8);
+        }
+        else if (arg.rfind("--answers=", 0) == 0) {
+            answersPath = arg.substr(10);
+        }
+        else {
+            std::cout << "unknown option " << arg << "\n";
+            return 1;
+        }
     }
 
-    // Ensure n doesn't exceed the vector's size
-    n = std::min(n, static_cast<int>(vec.size()));
-
-    // 1. Create a vector of pairs: {value, original_index}
-    std::vector<std::pair<float, int>> indexed_values;
-    indexed_values.reserve(vec.size()); // Pre-allocate memory for efficiency
-    for (int i = 0; i < vec.size(); ++i) {
-        indexed_values.push_back({ vec[i], i });
+    for (int i = 0; i < turns.size(); i++) {
+        if (turns[i].second.size() != boards) {
+            std::cout << "turn " << (i + 1) << " gives feedback for " << turns[i].second.size() << " boards, playing " << boards << "\n";
+            return 1;
+        }
     }
-
-    // 2. Partially sort the vector of pairs.
-    //    We only need the top 'n' elements to be in their correct sorted positions.
-    //    We sort in ascending order of float value. If values are equal,
-    //    we can use the index for stable ordering (e.g., smaller index first).
-    std::partial_sort(indexed_values.begin(),
-        indexed_values.begin() + n, // Sort only up to this point
-        indexed_values.end(),
-        [](const std::pair<float, int>& a, const std::pair<float, int>& b) {
-            if (a.first != b.first) {
-                return a.first < b.first; // <<--- CHANGED: Sort by value in ASCENDING order
-            }
-            // For tie-breaking (same value), prefer the smaller original index
-            return a.second < b.second;
-        });
-
-    // 3. Extract the indexes from the first 'n' elements of the partially sorted vector
-    std::vector<int> result_indexes;
-    result_indexes.reserve(n); // Pre-allocate memory
-    for (int i = 0; i < n; ++i) {
-        result_indexes.push_back(indexed_values[i].second);
+    if (deadline > 0 && (lookaheadMode || boards > 1 || serve || !treePath.empty() || !buildTreePath.empty() || !buildBookPath.empty())) {
+        std::cout << "a deadline only applies to a plain ranking, server requests pick theirs with deadline=\n";
+        return 1;
+    }
+    if (sampledMode && (!sampledMetric(metric) || deadline > 0 || lookaheadMode || boards > 1 || serve || !treePath.empty() || !buildTreePath.empty() || !buildBookPath.empty())) {
+        std::cout << "sampling only applies to a plain ranking by expected or entropy\n";
+        return 1;
+    }
+    if (hardMode && (lookaheadMode || boards > 1 || serve || !treePath.empty() || !buildTreePath.empty() || !buildBookPath.empty())) {
+        std::cout << "hard mode only applies to a plain ranking, server requests pick it with hard=1\n";
+        return 1;
+    }
+    MultiBoardObjective objective = MultiBoardObjective::SumExpected;
+    if (boards > 1) {
+        if (metric == ScoringMetric::ExpectedSize) objective = MultiBoardObjective::SumExpected;
+        else if (metric == ScoringMetric::SolveNow) objective = MultiBoardObjective::SolveAny;
+        else {
+            std::cout << "with several boards the metric must be expected or solve\n";
+            return 1;
+        }
+        if (serve || !treePath.empty() || !buildTreePath.empty() || !buildBookPath.empty() || lookaheadMode) {
+            std::cout << "several boards only rank guesses, they do not serve, use trees, books or lookahead\n";
+            return 1;
+        }
     }
 
-    return result_indexes;
-}
-
-//having multiple threads access the same filtered words array might cause cache issues lol
-float countAvgRemaining(const std::string& word, const std::vector<std::string>& wordlist) {
-    float sum = 0.0f;
+    //the sampled ranking packs its own sample and never reads the matrix, which would cost guesses x answers bytes
+    if (sampledMode) pattern_matrix_mode = false;
 
-    for (int i = 0; i < wordlist.size(); i++) {
-        WordFilter tempFilter{ wordlist[i], word };
-        sum += (float)tempFilter.filterWordsCount(wordlist);
+    SolverConfig config;
+    config.simdLevel = simdLevel;
+    config.pattern_mode = pattern_mode;
+    config.pattern_matrix_mode = pattern_matrix_mode;
+    config.patternMatrixPath = patternMatrixPath;
+    config.patternMatrixMaxBytes = patternMatrixMaxBytes;
+    config.hugePages = hugePages;
+#if _DEBUG
+    config.threads = 1;
+#endif
+    if (threads > 0) config.threads = threads;
+
+    if (selfTest) return (runSelfTests(cpuFeatures, config) == 0) ? 0 : 1;
+
+    //built in lists unless others were given
+    WordlistFile wordsFile;
+    WordlistFile answersFile;
+    const PackedWordTables* searchTables = &allWords;
+    const PackedWordTables* answerTables = &validWords;
+    std::string loadError;
+    if (!wordsPath.empty()) {
+        if (!wordsFile.load(wordsPath, loadError)) {
+            std::cout << loadError << "\n";
+            return 1;
+        }
+        searchTables = &wordsFile;
+    }
+    if (!answersPath.empty()) {
+        if (!answersFile.load(answersPath, loadError)) {
+            std::cout << loadError << "\n";
+            return 1;
+        }
+        answerTables = &answersFile;
     }
-    return sum / (float)wordlist.size();
-}
 
-struct CountAvgRemainingJobParams {
-    char word[5];
-    float* outputSum;
-    size_t wordsInList;
+    //set search words list
+    const std::vector<std::string>& selectedSearchWords = searchTables->strings();
+    const std::vector<std::string>& answerWords = answerTables->strings();
+    //the solver falls back to the pattern kernels past the cap, say so in the banners
+    if (pattern_matrix_mode && !PatternMatrix::fits(selectedSearchWords.size(), answerWords.size(), patternMatrixMaxBytes)) {
+        pattern_matrix_mode = false;
+    }
 
-    CountAvgRemainingJobParams() = default;
-    CountAvgRemainingJobParams(const char* word, float* out, size_t wordlistSize) : outputSum{out}, wordsInList { wordlistSize } {
-        std::memcpy(this->word, word, 5);
+    //guesses ranked per book position, enough for the listing below and any server request short of it
+    const int bookGuesses = 50;
+    OpeningBook book;
+    if (!bookPath.empty()) {
+        std::string bookError;
+        if (!book.load(bookPath, selectedSearchWords, answerWords, bookError)) {
+            std::cout << bookError << "\n";
+            return 1;
+        }
     }
-};
 
-void countAvgRemaining_pooljob(void* param, void* threadlocalstorage) {
-    CountAvgRemainingJobParams& params = *((CountAvgRemainingJobParams*)param);
+    if (serve) {
+        //replies go to stdout, so keep the banner off it
+        std::cerr << "Kernel: " << simdLevelName(simdLevel) << ", scoring: " << (pattern_matrix_mode ? "matrix" : (pattern_mode ? "pattern" : "filter")) << std::endl;
+
+        //one warm solver for every request
+        Solver solver{ config, selectedSearchWords, answerWords, answerTables };
+        if (!bookPath.empty()) solver.setOpeningBook(&book);
+        if (socketPath.empty()) return runStdioServer(solver);
+        return runUnixSocketServer(solver, socketPath);
+    }
 
-    float sum = 0.0f;
+    if (!treePath.empty()) {
+        //no solver, every turn is one hop down the tree
+        StrategyTree tree;
+        if (!tree.open(treePath, selectedSearchWords, answerWords)) {
+            std::cout << "could not open strategy tree " << treePath << ", it is missing, damaged or built for other word lists\n";
+            return 1;
+        }
 
-    for (int i = 0; i < params.wordsInList; i++) {
-        WordFilter tempFilter{ (char*)&(((unsigned char*)threadlocalstorage)[i * 5]), params.word };
-        sum += (float)tempFilter.optimized_filterWordsCount(((unsigned char*)threadlocalstorage), params.wordsInList, nullptr);
+        uint32_t node = tree.root();
+        for (int i = 0; i < turns.size(); i++) {
+            if (selectedSearchWords[tree.guess(node)] != turns[i].first) {
+                std::cout << "turn " << (i + 1) << " guessed " << turns[i].first << ", the tree plays " << selectedSearchWords[tree.guess(node)] << "\n";
+                return 1;
+            }
+            node = tree.child(node, turns[i].second[0]);
+            if (node == 0) {
+                std::cout << "solved or no answer gives that feedback\n";
+                return 0;
+            }
+        }
+        std::cout << "Next guess: " << selectedSearchWords[tree.guess(node)] << "\n";
+        return 0;
     }
 
-    *params.outputSum = sum / (float)params.wordsInList;
-}
+    std::cout << "Kernel: " << simdLevelName(simdLevel) << ", scoring: " << (pattern_matrix_mode ? "matrix" : (pattern_mode ? "pattern" : "filter")) << ", metric: " << scoringMetricName(metric) << "\n";
 
-void hyperavx_countAvgRemaining_pooljob(void* param, void* threadlocalstorage) {
-    CountAvgRemainingJobParams& params = *((CountAvgRemainingJobParams*)param);
+    if (!buildTreePath.empty()) {
+        Solver solver{ config, selectedSearchWords, answerWords, answerTables };
 
-    float sum = 0.0f;
+        auto start = std::chrono::steady_clock::now();
+        StrategyTreeStats stats;
+        std::string buildError;
+        if (!buildStrategyTree(solver, metric, buildTreePath, stats, buildError)) {
+            std::cout << buildError << "\n";
+            return 1;
+        }
+        auto end = std::chrono::steady_clock::now();
 
-    for (int i = 0; i < params.wordsInList; i++) {
-        WordFilter tempFilter{ (char*)&(((unsigned char*)threadlocalstorage)[i * 5]), params.word };
-        sum += (float)tempFilter.hyperpacked_optimized_filterWordsCount(((unsigned char*)threadlocalstorage), params.wordsInList);
+        std::cout << "Strategy tree: " << stats.nodes << " nodes, " << stats.averageGuesses << " guesses on average, " << stats.worstGuesses << " at worst\n";
+        std::cout << "Time: " << std::chrono::duration<double>(end - start).count() << "s\n";
+        return 0;
     }
 
-    *params.outputSum = sum / (float)params.wordsInList;
-}
-
-void hyperavx512_countAvgRemaining_pooljob(void* param, void* threadlocalstorage) {
-    CountAvgRemainingJobParams& params = *((CountAvgRemainingJobParams*)param);
+    if (!buildBookPath.empty()) {
+        Solver solver{ config, selectedSearchWords, answerWords, answerTables };
 
-    float sum = 0.0f;
+        auto start = std::chrono::steady_clock::now();
+        std::string buildError;
+        if (!buildOpeningBook(solver, metric, bookGuesses, buildBookPath, buildError)) {
+            std::cout << buildError << "\n";
+            return 1;
+        }
+        auto end = std::chrono::steady_clock::now();
 
-    for (int i = 0; i < params.wordsInList; i++) {
-        WordFilter tempFilter{ (char*)&(((unsigned char*)threadlocalstorage)[i * 5]), params.word };
-        sum += (float)tempFilter.hyperpacked_optimized_filterWordsCount_AVX512(((unsigned char*)threadlocalstorage), params.wordsInList);
+        std::cout << "Opening book written to " << buildBookPath << "\n";
+        std::cout << "Time: " << std::chrono::duration<double>(end - start).count() << "s\n";
+        return 0;
     }
 
-    *params.outputSum = sum / (float)params.wordsInList;
-}
+    if (boards > 1) {
+        Solver solver{ config, selectedSearchWords, answerWords, answerTables };
+
+        //one session per board, a board drops out once a turn solves it
+        std::vector<std::vector<std::string>> boardCandidates(boards);
+        int unmatchedBoards = 0;
+        for (int b = 0; b < boards; b++) {
+            GameSession session{ answerWords, simdLevel };
+            bool solved = false;
+            for (int i = 0; i < turns.size() && !solved; i++) {
+                solved = turns[i].second[b] == SOLVED_FEEDBACK_CODE;
+                if (!solved) session.applyFeedback(turns[i].first.c_str(), turns[i].second[b]);
+            }
 
-int main()
-{
-    // 
-    // NOTE BEFORE USE:
-    // NASM and the Visual Studio extension VSNASM is required to compile this project.
-    // Build in x64 mode ONLY, assembly uses the Windows x64 ABI
-    // AVX and SSE4.2 required
-    //
+            if (solved) {
+                std::cout << "Board " << (b + 1) << ": solved\n";
+                continue;
+            }
+            for (int i = 0; i < session.size(); i++) {
+                boardCandidates[b].emplace_back(session.candidateWord(i), 5);
+            }
+            std::cout << "Board " << (b + 1) << ": " << boardCandidates[b].size() << " possible answers\n";
+            if (boardCandidates[b].empty()) unmatchedBoards++;
+        }
+        std::cout << std::endl;
+
+        if (unmatchedBoards > 0) {
+            std::cout << "No answer matches the feedback on " << unmatchedBoards << " board(s), nothing to rank\n";
+            return 1;
+        }
 
-    // TODO: filters do not work when hyperavx mode is on
-    // process words in simd parallel
-    constexpr bool hyperavx_mode = true;
-    constexpr bool avx512_mode = true;
-    constexpr int packwidth = avx512_mode ? 64 : 32;
+        const int numBestResponses = bookGuesses;
+        auto start = std::chrono::steady_clock::now();
+        std::vector<MultiBoardGuess> bestGuesses = solver.rankGuessesMultiBoard(boardCandidates, numBestResponses, objective);
+        auto end = std::chrono::steady_clock::now();
+
+        std::cout << "Best " << bestGuesses.size() << " responses (expected candidates left over all boards, chance to solve one): \n";
+        for (int i = 0; i < bestGuesses.size(); i++) {
+            std::cout << selectedSearchWords[bestGuesses[i].guessIdx] << "\t" << bestGuesses[i].expectedRemaining << "\t" << bestGuesses[i].solveAnyChance << "\n";
+        }
+        std::cout << "Time: " << std::chrono::duration<double>(end - start).count() << "s\n";
+        return 0;
+    }
 
     std::array<char, 5> correct = { ' ', ' ', ' ', ' ', ' ' };
     std::array<std::vector<char>, 5> misplaced = {{
@@ -143,26 +458,58 @@ int main()
     }};
     std::string wrong = "";
 
-    std::cout << "Using configuration:\n";
-    std::cout << "Correct characters: ";
-    for (int i = 0; i < correct.size(); i++) {
-        std::cout << ((correct[i] == ' ') ? '_' : correct[i]);
-    }
-    std::cout << "\n";
+    if (turns.empty()) {
+        std::cout << "Using configuration:\n";
+        std::cout << "Correct characters: ";
+        for (int i = 0; i < correct.size(); i++) {
+            std::cout << ((correct[i] == ' ') ? '_' : correct[i]);
+        }
+        std::cout << "\n";
 
-    std::cout << "Misplaced characters: \n";
-    for (int i = 0; i < misplaced.size(); i++) {
-        std::cout << "At idx " << i << ": { ";
-        for (int j = 0; j < misplaced[i].size(); j++) {
-            std::cout << misplaced[i][j] << ", ";
+        std::cout << "Misplaced characters: \n";
+        for (int i = 0; i < misplaced.size(); i++) {
+            std::cout << "At idx " << i << ": { ";
+            for (int j = 0; j < misplaced[i].size(); j++) {
+                std::cout << misplaced[i][j] << ", ";
+            }
+            std::cout << "}\n";
         }
-        std::cout << "}\n";
+
+        std::cout << "Wrong characters: " << wrong << std::endl;
+    }
+    else {
+        //the session narrows the answers from these, the configuration above would be left empty
+        std::cout << "Using turns:\n";
+        for (int i = 0; i < turns.size(); i++) {
+            unsigned char states[5];
+            feedbackCodeStates(turns[i].second[0], states);
+            std::cout << turns[i].first << ": ";
+            for (int j = 0; j < 5; j++) std::cout << (int)states[j];
+            std::cout << "\n";
+        }
+        std::cout << std::endl;
     }
 
-    std::cout << "Wrong characters: " << wrong << std::endl;
+    Solver solver{ config, selectedSearchWords, answerWords, answerTables };
+    if (!bookPath.empty()) solver.setOpeningBook(&book);
+    const int numBestResponses = bookGuesses;
+
+    WordFilter filter{ correct, misplaced, wrong };
+    std::vector<std::string> filteredWords;
+    if (turns.empty()) {
+        filteredWords = solver.filterAnswers(filter);
+    }
+    else {
+        GameSession session{ answerWords, simdLevel };
+        for (int i = 0; i < turns.size(); i++) {
+            session.applyFeedback(turns[i].first.c_str(), turns[i].second[0]);
+        }
 
-    WordFilter filter { correct, misplaced, wrong };
-    std::vector<std::string> filteredWords = filter.filterWords(validWords);
+        filteredWords.reserve(session.size());
+        for (int i = 0; i < session.size(); i++) {
+            filteredWords.emplace_back(session.candidateWord(i), 5);
+        }
+    }
 
     std::cout << "All possible answers (Total " << filteredWords.size() << ") : \n";
     for (int i = 0; i < filteredWords.size(); i++) {
@@ -170,101 +517,67 @@ int main()
     }
     std::cout << std::endl;
 
-    //stuff
-    
-
-    //set search words list
-    const std::vector<std::string>& selectedSearchWords = allWords;
-
-    //allocate task list
-    std::vector<CountAvgRemainingJobParams> jobParams;
-    jobParams.reserve(selectedSearchWords.size()); jobParams.resize(selectedSearchWords.size());
-
-    std::vector<JobRecipe> sumJobs;
-    sumJobs.reserve(selectedSearchWords.size()); sumJobs.resize(selectedSearchWords.size());
-
-    std::vector<float> sumsOutputs;
-    sumsOutputs.reserve(selectedSearchWords.size()); sumsOutputs.resize(selectedSearchWords.size());
-    //fine line between undefined behavior
-    //it might be
-
-#if _DEBUG
-    ThreadPool pool{ 1 };
-#else 
-    ThreadPool pool{ 12 };
-#endif
-
+    if (filteredWords.empty()) {
+        std::cout << "No answer matches the feedback, nothing to rank\n";
+        return 1;
+    }
 
     auto start = std::chrono::steady_clock::now();
-    if (hyperavx_mode) {
-        //build optimally packed wordlist
-        // [w0c0], [w1c0], [w2c0], ... [w32c0]
-        // [w0c1], [w1c1], [w2c1], ... [w32c1]
-        // [w0c2], [w1c2], [w2c2], ... [w32c2]
-        // .
-        // .
-        // .
-        // [wNc5], [wNc2], [wNc5], ... [wNc5]
-
-        size_t optimizedFilteredList_bytes = ((filteredWords.size() / packwidth) + 1) * packwidth * 5;
-        char* optimizedFilteredList = new char[optimizedFilteredList_bytes];
-
-        //zero the buffer
-        std::memset(optimizedFilteredList, 0, optimizedFilteredList_bytes);
-
-        for (int i = 0; i < filteredWords.size(); i += packwidth) {
-            for (int j = 0; j < 5; j++) {
-                for (int k = 0; k < packwidth; k++) {
-                    if ( (i + k) < filteredWords.size() )
-                        optimizedFilteredList[(i * 5) + (j * packwidth) + (k)] = filteredWords[i+k].c_str()[j];
-                }
-            }
-        }
-        std::cout << "built packed filter list" << std::endl;
-        
-        pool.allocateThreadLocalStorage(optimizedFilteredList, optimizedFilteredList_bytes, packwidth);
-        //can deallocate the packed list now
-        delete[] optimizedFilteredList;
-
-        //build jobs
-        for (int i = 0; i < selectedSearchWords.size(); i++) {
-            jobParams[i] = CountAvgRemainingJobParams(selectedSearchWords[i].c_str(), &(sumsOutputs.data()[i]), filteredWords.size());
-            if (avx512_mode)
-                sumJobs[i] = JobRecipe(&(jobParams.data()[i]), &hyperavx512_countAvgRemaining_pooljob);
-            else
-                sumJobs[i] = JobRecipe(&(jobParams.data()[i]), &hyperavx_countAvgRemaining_pooljob);
+    std::vector<int> legalGuesses;
+    if (hardMode) {
+        std::vector<std::pair<std::string, unsigned char>> played;
+        for (int i = 0; i < turns.size(); i++) {
+            played.emplace_back(turns[i].first, turns[i].second[0]);
         }
+        legalGuesses = solver.legalGuesses(playedTurnsFilter(filter, played));
+        std::cout << "Hard mode: " << legalGuesses.size() << " of " << selectedSearchWords.size() << " guesses allowed\n";
     }
-    else {
-        //allocate thread local storage
-        size_t optimizedFilteredList_bytes = filteredWords.size() * 5;
-        char* optimizedFilteredList = new char[optimizedFilteredList_bytes];
-        for (int i = 0; i < filteredWords.size(); i++) {
-            std::memcpy(&(optimizedFilteredList[i * 5]), filteredWords[i].c_str(), 5);
-        }
 
-        //align to cache line?
-        pool.allocateThreadLocalStorage(optimizedFilteredList, optimizedFilteredList_bytes, 64); // 64 for a placeholder
-        delete[] optimizedFilteredList;
+    if (lookaheadMode) {
+        std::vector<LookaheadGuess> bestGuesses = solver.rankGuessesLookahead(filteredWords, lookahead, metric);
+        auto end = std::chrono::steady_clock::now();
 
-        //build jobs
-        for (int i = 0; i < selectedSearchWords.size(); i++) {
-            jobParams[i] = CountAvgRemainingJobParams(selectedSearchWords[i].c_str(), &(sumsOutputs.data()[i]), filteredWords.size());
-            sumJobs[i] = JobRecipe(&(jobParams.data()[i]), &countAvgRemaining_pooljob);
+        std::cout << "Best " << bestGuesses.size() << " responses by expected guesses (" << scoringMetricName(metric) << " in brackets): \n";
+        for (int i = 0; i < bestGuesses.size(); i++) {
+            std::cout << selectedSearchWords[bestGuesses[i].guessIdx] << "\t";
+            if (bestGuesses[i].expanded) std::cout << bestGuesses[i].expectedGuesses;
+            else std::cout << "-";
+            std::cout << "\t(" << bestGuesses[i].onePlyScore << ")\n";
         }
+        std::cout << "Time: " << std::chrono::duration<double>(end - start).count() << "s\n";
     }
-    pool.QueueBatchTask(sumJobs.data(), sumJobs.size());
-    pool.WaitCompletion();
-    auto end = std::chrono::steady_clock::now();
-    
+    else if (sampledMode) {
+        std::vector<SampledGuess> bestGuesses = solver.rankGuessesSampled(filteredWords, numBestResponses, metric, sampling, hardMode ? &legalGuesses : nullptr);
+        auto end = std::chrono::steady_clock::now();
 
-    const int numBestResponses = 50;
-    std::vector<int> largestSumsIdxs = get_smallest_n_indexes(sumsOutputs, numBestResponses);
-
-    std::cout << "Best " << numBestResponses << " responses: \n";
-    for (int i = 0; i < largestSumsIdxs.size(); i++) {
-        std::cout << selectedSearchWords[largestSumsIdxs[i]] << "\t" << sumsOutputs[largestSumsIdxs[i]] << "\n";
+        std::cout << "Best " << bestGuesses.size() << " responses (estimate, error bar, candidates sampled): \n";
+        for (int i = 0; i < bestGuesses.size(); i++) {
+            std::cout << selectedSearchWords[bestGuesses[i].guessIdx] << "\t" << bestGuesses[i].estimate << "\t+-" << bestGuesses[i].errorBar << "\t(" << bestGuesses[i].sampled << ")\n";
+        }
+        std::cout << "Time: " << std::chrono::duration<double>(end - start).count() << "s\n";
     }
+    else if (deadline > 0) {
+        DeadlineRanking bestGuesses = solver.rankGuessesDeadline(filteredWords, numBestResponses, deadline, metric, hardMode ? &legalGuesses : nullptr);
+        auto end = std::chrono::steady_clock::now();
 
-    std::cout << "Time: " << std::chrono::duration_cast<std::chrono::seconds>(end - start).count() << "." << (std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() % 1000) << "s\n";
+        std::cout << "Best " << bestGuesses.guesses.size() << " responses out of " << bestGuesses.evaluated << " of " << bestGuesses.total << " guesses evaluated: \n";
+        for (int i = 0; i < bestGuesses.guesses.size(); i++) {
+            std::cout << selectedSearchWords[bestGuesses.guesses[i].guessIdx] << "\t" << bestGuesses.guesses[i].score << "\n";
+        }
+        std::cout << "Time: " << std::chrono::duration<double>(end - start).count() << "s\n";
+    }
+    else {
+        //with no turns the ranking narrows the packed answers itself, the strings are only for the listing
+        const std::vector<int>* guessIdxs = hardMode ? &legalGuesses : nullptr;
+        std::vector<ScoredGuess> bestGuesses = turns.empty()
+            ? solver.rankGuesses(filter, numBestResponses, metric, nullptr, guessIdxs)
+            : solver.rankGuesses(filteredWords, numBestResponses, metric, guessIdxs);
+        auto end = std::chrono::steady_clock::now();
+
+        std::cout << "Best " << bestGuesses.size() << " responses: \n";
+        for (int i = 0; i < bestGuesses.size(); i++) {
+            std::cout << selectedSearchWords[bestGuesses[i].guessIdx] << "\t" << bestGuesses[i].score << "\n";
+        }
+        std::cout << "Time: " << std::chrono::duration<double>(end - start).count() << "s\n";
+    }
 }
\ No newline at end of file
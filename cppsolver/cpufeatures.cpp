@@ -0,0 +1,102 @@
+#include "cpufeatures.hpp"
+#include "words.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+static void cpuid(int leaf, int subleaf, unsigned int regs[4]) {
+#ifdef _MSC_VER
+    int out[4];
+    __cpuidex(out, leaf, subleaf);
+    for (int i = 0; i < 4; i++) regs[i] = (unsigned int)out[i];
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static unsigned long long xgetbv0() {
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned int eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((unsigned long long)edx << 32) | eax;
+#endif
+}
+
+CpuFeatures detectCpuFeatures() {
+    CpuFeatures features;
+    unsigned int regs[4];
+
+    cpuid(0, 0, regs);
+    unsigned int maxLeaf = regs[0];
+    if (maxLeaf < 1) return features;
+
+    cpuid(1, 0, regs);
+    features.sse42 = (regs[2] >> 20) & 1;
+    bool osxsave = (regs[2] >> 27) & 1;
+    bool avx = (regs[2] >> 28) & 1;
+
+    if (!osxsave || !avx || maxLeaf < 7) return features;
+
+    // XCR0: bits 1-2 are SSE/AVX state, bits 5-7 are the AVX-512 opmask/ZMM state
+    unsigned long long xcr0 = xgetbv0();
+    bool osYmm = (xcr0 & 0x6) == 0x6;
+    bool osZmm = (xcr0 & 0xE6) == 0xE6;
+
+    cpuid(7, 0, regs);
+    features.avx2 = osYmm && ((regs[1] >> 5) & 1);
+    bool avx512f = (regs[1] >> 16) & 1;
+    bool avx512bw = (regs[1] >> 30) & 1;
+    features.avx512bw = osZmm && features.avx2 && avx512f && avx512bw;
+    features.avx512vbmi2 = features.avx512bw && ((regs[2] >> 6) & 1);
+
+    return features;
+}
+
+SimdLevel bestSimdLevel(const CpuFeatures& features) {
+    if (features.avx512bw) return SimdLevel::AVX512;
+    if (features.avx2) return SimdLevel::AVX2;
+    if (features.sse42) return SimdLevel::SSE42;
+    return SimdLevel::Scalar;
+}
+
+bool simdLevelSupported(const CpuFeatures& features, SimdLevel level) {
+    switch (level) {
+    case SimdLevel::AVX512: return features.avx512bw;
+    case SimdLevel::AVX2: return features.avx2;
+    case SimdLevel::SSE42: return features.sse42;
+    default: return true;
+    }
+}
+
+int simdLevelPackWidth(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::AVX512: return 64;
+    case SimdLevel::AVX2: return 32;
+    default: return 0;
+    }
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::AVX512: return "avx512";
+    case SimdLevel::AVX2: return "avx2";
+    case SimdLevel::SSE42: return "sse42";
+    default: return "scalar";
+    }
+}
+
+bool parseSimdLevel(const std::string& name, SimdLevel& level) {
+    const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::SSE42, SimdLevel::AVX2, SimdLevel::AVX512 };
+    for (SimdLevel l : levels) {
+        if (name == simdLevelName(l)) {
+            level = l;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+// fastest kernel family the host can run, in increasing order
+enum class SimdLevel {
+    Scalar,  // WordFilter::filterWordsCount / PatternWordlist
+    SSE42,   // WordFilter::optimized_filterWordsCount (nasm helpers)
+    AVX2,    // hyperpacked kernels, 32 words per batch
+    AVX512   // hyperpacked kernels, 64 words per batch (needs AVX-512BW)
+};
+
+struct CpuFeatures {
+    bool sse42 = false;
+    bool avx2 = false;
+    bool avx512bw = false;
+    bool avx512vbmi2 = false; // vpcompressb, only set alongside avx512bw
+};
+
+// queries CPUID and XGETBV, so registers the OS doesn't save are treated as unsupported
+CpuFeatures detectCpuFeatures();
+
+SimdLevel bestSimdLevel(const CpuFeatures& features);
+bool simdLevelSupported(const CpuFeatures& features, SimdLevel level);
+
+// bytes per row of the hyperpacked layout, 0 for the flat layouts
+int simdLevelPackWidth(SimdLevel level);
+
+const char* simdLevelName(SimdLevel level);
+// accepts the names returned by simdLevelName, false if unknown
+bool parseSimdLevel(const std::string& name, SimdLevel& level);
+
+// bit counting for code every host runs, the popcnt and tzcnt instructions are only safe in the kernel files
+inline int portablePopcount(uint64_t bits) {
+    bits = bits - ((bits >> 1) & 0x5555555555555555ULL);
+    bits = (bits & 0x3333333333333333ULL) + ((bits >> 2) & 0x3333333333333333ULL);
+    bits = (bits + (bits >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int)((bits * 0x0101010101010101ULL) >> 56);
+}
+
+// index of the lowest set bit, bits must not be 0 (de Bruijn multiply)
+inline int lowestSetBit(uint64_t bits) {
+    static constexpr unsigned char positions[64] = {
+        0, 1, 48, 2, 57, 49, 28, 3, 61, 58, 50, 42, 38, 29, 17, 4, 62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12, 5,
+        63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11, 46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19, 9, 13, 8, 7, 6
+    };
+    return positions[((bits & (0 - bits)) * 0x03F79D71B4CB0A89ULL) >> 58];
+}
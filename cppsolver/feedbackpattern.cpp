@@ -0,0 +1,145 @@
+#include "feedbackpattern.hpp"
+#include "words.h"
+
+#include <cstring>
+
+static constexpr int feedbackDigitWeights[5] = { 1, 3, 9, 27, 81 };
+
+//a guess without a repeated letter can only be misplaced against a copy that isn't its own green,
+//so present anywhere in the answer is already Wordle's rule for it
+static inline bool hasRepeatedLetter(const unsigned char* guess) {
+    return guess[0] == guess[1] || guess[0] == guess[2] || guess[0] == guess[3] || guess[0] == guess[4]
+        || guess[1] == guess[2] || guess[1] == guess[3] || guess[1] == guess[4]
+        || guess[2] == guess[3] || guess[2] == guess[4]
+        || guess[3] == guess[4];
+}
+
+//Wordle's duplicate letter rule: greens first, then each other guess letter, left to right,
+//is misplaced only while the answer still has a copy of it that nothing matched yet
+static inline unsigned char repeatedLetterFeedbackCode(const unsigned char* answer, const unsigned char* guess) {
+    unsigned char unmatched[32] = {};
+    int code = 0;
+    for (int i = 0; i < 5; i++) {
+        if (answer[i] == guess[i]) code += 2 * feedbackDigitWeights[i];
+        else unmatched[answer[i] & 31]++;
+    }
+    for (int i = 0; i < 5; i++) {
+        if (answer[i] != guess[i] && unmatched[guess[i] & 31] != 0) {
+            unmatched[guess[i] & 31]--;
+            code += feedbackDigitWeights[i];
+        }
+    }
+    return (unsigned char)code;
+}
+
+static inline unsigned char feedbackCodeWithMask(const unsigned char* answer, uint32_t answerMask, const unsigned char* guess, bool guessRepeats) {
+    if (guessRepeats) return repeatedLetterFeedbackCode(answer, guess);
+
+    int code = 0;
+    for (int i = 0; i < 5; i++) {
+        int digit = (answer[i] == guess[i]) ? 2 : (int)((answerMask >> (guess[i] & 31)) & 1);
+        code += digit * feedbackDigitWeights[i];
+    }
+    return (unsigned char)code;
+}
+
+unsigned char computeFeedbackCode(const char* answer, const char* guess) {
+    const unsigned char* a = (const unsigned char*)answer;
+    const unsigned char* g = (const unsigned char*)guess;
+    return feedbackCodeWithMask(a, wordLetterMask(a), g, hasRepeatedLetter(g));
+}
+
+bool parseFeedbackPattern(const std::string& digits, unsigned char& code) {
+    if (digits.size() != 5) return false;
+
+    int value = 0;
+    for (int i = 0; i < 5; i++) {
+        if (digits[i] < '0' || digits[i] > '2') return false;
+        value += (digits[i] - '0') * feedbackDigitWeights[i];
+    }
+    code = (unsigned char)value;
+    return true;
+}
+
+void feedbackCodeStates(unsigned char code, unsigned char* states) {
+    int value = code;
+    for (int i = 0; i < 5; i++) {
+        states[i] = (unsigned char)(value % 3);
+        value /= 3;
+    }
+}
+
+PatternWordlist::PatternWordlist(const std::vector<std::string>& wordlist) {
+    this->packedWords.resize(wordlist.size() * 5);
+    this->letterMasks.resize(wordlist.size());
+
+    for (int i = 0; i < wordlist.size(); i++) {
+        std::memcpy(&(this->packedWords[i * 5]), wordlist[i].c_str(), 5);
+        this->letterMasks[i] = wordLetterMask(&(this->packedWords[i * 5]));
+    }
+}
+
+PatternWordlist::PatternWordlist(const unsigned char* wordlist, size_t words) {
+    this->packedWords.assign(wordlist, wordlist + words * 5);
+    this->letterMasks.resize(words);
+
+    for (size_t i = 0; i < words; i++) {
+        this->letterMasks[i] = wordLetterMask(&(this->packedWords[i * 5]));
+    }
+}
+
+unsigned char PatternWordlist::feedbackCode(size_t answerIdx, const char* guess) const {
+    const unsigned char* g = (const unsigned char*)guess;
+    return feedbackCodeWithMask(&(this->packedWords[answerIdx * 5]), this->letterMasks[answerIdx], g, hasRepeatedLetter(g));
+}
+
+void PatternWordlist::buildHistogram(const char* guess, int* histogram) const {
+    std::memset(histogram, 0, sizeof(int) * FEEDBACK_CODE_COUNT);
+
+    const unsigned char* g = (const unsigned char*)guess;
+    const unsigned char* words = this->packedWords.data();
+    const uint32_t* masks = this->letterMasks.data();
+    size_t n = this->letterMasks.size();
+    bool repeats = hasRepeatedLetter(g);
+
+    for (size_t i = 0; i < n; i++) {
+        histogram[feedbackCodeWithMask(&(words[i * 5]), masks[i], g, repeats)]++;
+    }
+}
+
+int64_t PatternWordlist::accumulateHistogram(const char* guess, size_t begin, size_t end, int* histogram) const {
+    const unsigned char* g = (const unsigned char*)guess;
+    const unsigned char* words = this->packedWords.data();
+    const uint32_t* masks = this->letterMasks.data();
+    bool repeats = hasRepeatedLetter(g);
+
+    //(h + 1)^2 - h^2 = 2h + 1
+    int64_t growth = 0;
+    for (size_t i = begin; i < end; i++) {
+        int& bucket = histogram[feedbackCodeWithMask(&(words[i * 5]), masks[i], g, repeats)];
+        growth += 2 * bucket + 1;
+        bucket++;
+    }
+    return growth;
+}
+
+float PatternWordlist::countAvgRemaining(const char* guess) const {
+    if (this->letterMasks.empty()) return 0.0f;
+
+    int histogram[FEEDBACK_CODE_COUNT];
+    this->buildHistogram(guess, histogram);
+
+    return histogramAvgRemaining(histogram, this->letterMasks.size());
+}
+
+float histogramAvgRemaining(const int* histogram, size_t words) {
+    if (words == 0) return 0.0f;
+
+    //every answer in a bucket leaves the whole bucket remaining
+    int64_t sum = 0;
+    for (int i = 0; i < FEEDBACK_CODE_COUNT; i++) {
+        sum += (int64_t)histogram[i] * histogram[i];
+    }
+
+    return (float)sum / (float)words;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+// 3^5 possible feedback codes for a 5 letter guess
+constexpr int FEEDBACK_CODE_COUNT = 243;
+// every letter correct, 22222
+constexpr int SOLVED_FEEDBACK_CODE = FEEDBACK_CODE_COUNT - 1;
+
+// base-3 feedback code, position 0 is the least significant digit
+// per position: 2 = correct, 1 = misplaced, 0 = wrong
+// follows Wordle for repeated letters: greens are matched first, then each other guess letter, left to right,
+// is misplaced only while the answer has an unmatched copy left, so "speed" against "abide" is 00101
+// uses the same rules as WordFilter(solution, guess), so a word passes WordFilter{ answer, guess }
+// exactly when it produces the same code as answer
+unsigned char computeFeedbackCode(const char* answer, const char* guess);
+
+// 5 digits of 0/1/2 (wrong/misplaced/correct), first letter first, e.g. "00120"
+bool parseFeedbackPattern(const std::string& digits, unsigned char& code);
+// the 5 digits of code, first letter first, the per position states WordFilter::feedbackStates gives
+void feedbackCodeStates(unsigned char code, unsigned char* states);
+
+// letter presence bitmask, bit (c & 31) is set for every letter c in the word
+inline uint32_t wordLetterMask(const unsigned char* word) {
+    return (1u << (word[0] & 31)) | (1u << (word[1] & 31)) | (1u << (word[2] & 31))
+        | (1u << (word[3] & 31)) | (1u << (word[4] & 31));
+}
+
+//SIMD versions of computeFeedbackCode, same repeated letter rule, over the hyperpacked layout built in main
+//(5 rows of 32 or 64 bytes per batch, zero padded), one code per lane
+//padding lanes always produce code 0
+//codes must hold words rounded up to the batch size, 32 for AVX2 and 64 for AVX512
+void hyperpacked_feedbackCodes(const char* guess, const unsigned char* hyperpacked_wordlist, size_t words, unsigned char* codes);
+void hyperpacked_feedbackCodes_AVX512(const char* guess, const unsigned char* hyperpacked_wordlist, size_t words, unsigned char* codes);
+
+//histogram must hold FEEDBACK_CODE_COUNT ints, it is overwritten, padding lanes are not counted
+void hyperpacked_feedbackHistogram(const char* guess, const unsigned char* hyperpacked_wordlist, size_t words, int* histogram);
+void hyperpacked_feedbackHistogram_AVX512(const char* guess, const unsigned char* hyperpacked_wordlist, size_t words, int* histogram);
+
+//sum(bucket^2) / n
+float histogramAvgRemaining(const int* histogram, size_t words);
+
+//candidate list prepared for pattern scoring
+//scores a guess in one pass over the answers instead of one filter pass per answer
+class PatternWordlist {
+public:
+    explicit PatternWordlist(const std::vector<std::string>& wordlist);
+    PatternWordlist(const unsigned char* wordlist, size_t words);
+
+    size_t size() const { return this->letterMasks.size(); }
+    const unsigned char* data() const { return this->packedWords.data(); }
+
+    unsigned char feedbackCode(size_t answerIdx, const char* guess) const;
+
+    //histogram must hold FEEDBACK_CODE_COUNT ints, it is overwritten
+    void buildHistogram(const char* guess, int* histogram) const;
+    //adds answers [begin, end) to histogram without clearing it, returns how much sum(bucket^2) grew
+    int64_t accumulateHistogram(const char* guess, size_t begin, size_t end, int* histogram) const;
+
+    //same value as averaging WordFilter{ answer, guess }.filterWordsCount over every answer
+    //sum(bucket^2) / n
+    float countAvgRemaining(const char* guess) const;
+
+private:
+    std::vector<unsigned char> packedWords; //flat, 5 bytes per word
+    std::vector<uint32_t> letterMasks;
+};
@@ -0,0 +1,146 @@
+#include "feedbackpattern.hpp"
+#include "words.h"
+
+#include <array>
+#include <cstring>
+
+// digit for guess position i is present_i + correct_i (correct implies present)
+// so each lane's code is the sum of the weight 3^i masked by both compares
+// present anywhere is Wordle's rule as long as the guess has no repeated letter
+static inline __m256i feedbackCodeBatch(const std::array<__m256i, 5>& ymm_word_char_cols, const std::array<__m256i, 5>& ymm_guess_chars_bcast, const std::array<__m256i, 5>& ymm_digit_weights) {
+    __m256i ymm_code = _mm256_setzero_si256();
+
+    for (int i = 0; i < 5; ++i) {
+        __m256i ymm_correct = _mm256_cmpeq_epi8(ymm_word_char_cols[i], ymm_guess_chars_bcast[i]);
+
+        __m256i ymm_present = ymm_correct;
+        for (int k = 0; k < 5; ++k) {
+            if (k == i) continue;
+            ymm_present = _mm256_or_si256(ymm_present, _mm256_cmpeq_epi8(ymm_word_char_cols[k], ymm_guess_chars_bcast[i]));
+        }
+
+        ymm_code = _mm256_add_epi8(ymm_code, _mm256_and_si256(ymm_present, ymm_digit_weights[i]));
+        ymm_code = _mm256_add_epi8(ymm_code, _mm256_and_si256(ymm_correct, ymm_digit_weights[i]));
+    }
+
+    return ymm_code;
+}
+
+// Wordle's repeated letter rule, for guesses that repeat a letter
+// guess position i is misplaced only while the answer has more copies of its letter off the greens
+// than earlier positions with the same letter already took, counted per lane with the -1 compare masks
+static inline __m256i feedbackCodeBatchRepeated(const std::array<__m256i, 5>& ymm_word_char_cols, const std::array<__m256i, 5>& ymm_guess_chars_bcast, const std::array<__m256i, 5>& ymm_digit_weights, const char* guess) {
+    __m256i ymm_code = _mm256_setzero_si256();
+    __m256i ymm_zero = _mm256_setzero_si256();
+    std::array<__m256i, 5> ymm_correct;
+    std::array<__m256i, 5> ymm_misplaced;
+
+    for (int j = 0; j < 5; ++j) {
+        ymm_correct[j] = _mm256_cmpeq_epi8(ymm_word_char_cols[j], ymm_guess_chars_bcast[j]);
+    }
+
+    for (int i = 0; i < 5; ++i) {
+        __m256i ymm_unmatched = ymm_zero;
+        for (int k = 0; k < 5; ++k) {
+            ymm_unmatched = _mm256_sub_epi8(ymm_unmatched, _mm256_andnot_si256(ymm_correct[k], _mm256_cmpeq_epi8(ymm_word_char_cols[k], ymm_guess_chars_bcast[i])));
+        }
+        for (int k = 0; k < i; ++k) {
+            if (guess[k] == guess[i]) ymm_unmatched = _mm256_add_epi8(ymm_unmatched, ymm_misplaced[k]);
+        }
+        ymm_misplaced[i] = _mm256_andnot_si256(ymm_correct[i], _mm256_cmpgt_epi8(ymm_unmatched, ymm_zero));
+
+        ymm_code = _mm256_add_epi8(ymm_code, _mm256_and_si256(ymm_misplaced[i], ymm_digit_weights[i]));
+        ymm_code = _mm256_add_epi8(ymm_code, _mm256_and_si256(ymm_correct[i], _mm256_add_epi8(ymm_digit_weights[i], ymm_digit_weights[i])));
+    }
+
+    return ymm_code;
+}
+
+static inline bool hasRepeatedLetter(const char* guess) {
+    for (int i = 0; i < 5; ++i) {
+        for (int k = i + 1; k < 5; ++k) {
+            if (guess[k] == guess[i]) return true;
+        }
+    }
+    return false;
+}
+
+static inline void loadFeedbackGuess(const char* guess, std::array<__m256i, 5>& ymm_guess_chars_bcast, std::array<__m256i, 5>& ymm_digit_weights) {
+    int weight = 1;
+    for (int i = 0; i < 5; ++i) {
+        ymm_guess_chars_bcast[i] = _mm256_set1_epi8(guess[i]);
+        ymm_digit_weights[i] = _mm256_set1_epi8((char)weight);
+        weight *= 3;
+    }
+}
+
+void hyperpacked_feedbackCodes(const char* guess, const unsigned char* hyperpacked_wordlist, size_t words, unsigned char* codes) {
+    const int BATCH_SIZE = 32;
+    std::array<__m256i, 5> ymm_guess_chars_bcast;
+    std::array<__m256i, 5> ymm_digit_weights;
+    std::array<__m256i, 5> ymm_word_char_cols;
+    loadFeedbackGuess(guess, ymm_guess_chars_bcast, ymm_digit_weights);
+    bool repeats = hasRepeatedLetter(guess);
+
+    size_t num_batches = (words + BATCH_SIZE - 1) / BATCH_SIZE;
+
+    for (size_t batch_idx = 0; batch_idx < num_batches; ++batch_idx) {
+        size_t soa_batch_base_offset = batch_idx * 5 * BATCH_SIZE;
+
+        for (int j = 0; j < 5; ++j) {
+            ymm_word_char_cols[j] = _mm256_load_si256(
+                reinterpret_cast<const __m256i*>(&hyperpacked_wordlist[soa_batch_base_offset + j * BATCH_SIZE])
+            );
+        }
+
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(&codes[batch_idx * BATCH_SIZE]),
+            (repeats ? feedbackCodeBatchRepeated(ymm_word_char_cols, ymm_guess_chars_bcast, ymm_digit_weights, guess) : feedbackCodeBatch(ymm_word_char_cols, ymm_guess_chars_bcast, ymm_digit_weights))
+        );
+    }
+}
+
+void hyperpacked_feedbackHistogram(const char* guess, const unsigned char* hyperpacked_wordlist, size_t words, int* histogram) {
+    const int BATCH_SIZE = 32;
+    std::array<__m256i, 5> ymm_guess_chars_bcast;
+    std::array<__m256i, 5> ymm_digit_weights;
+    std::array<__m256i, 5> ymm_word_char_cols;
+    loadFeedbackGuess(guess, ymm_guess_chars_bcast, ymm_digit_weights);
+    bool repeats = hasRepeatedLetter(guess);
+
+    // 4 interleaved counters so repeated codes don't serialize on one store
+    int sub_histograms[4][256];
+    std::memset(sub_histograms, 0, sizeof(sub_histograms));
+    alignas(32) unsigned char batch_codes[BATCH_SIZE];
+
+    size_t num_batches = (words + BATCH_SIZE - 1) / BATCH_SIZE;
+
+    for (size_t batch_idx = 0; batch_idx < num_batches; ++batch_idx) {
+        size_t soa_batch_base_offset = batch_idx * 5 * BATCH_SIZE;
+
+        for (int j = 0; j < 5; ++j) {
+            ymm_word_char_cols[j] = _mm256_load_si256(
+                reinterpret_cast<const __m256i*>(&hyperpacked_wordlist[soa_batch_base_offset + j * BATCH_SIZE])
+            );
+        }
+
+        _mm256_store_si256(
+            reinterpret_cast<__m256i*>(batch_codes),
+            (repeats ? feedbackCodeBatchRepeated(ymm_word_char_cols, ymm_guess_chars_bcast, ymm_digit_weights, guess) : feedbackCodeBatch(ymm_word_char_cols, ymm_guess_chars_bcast, ymm_digit_weights))
+        );
+
+        for (int k = 0; k < BATCH_SIZE; k += 4) {
+            sub_histograms[0][batch_codes[k + 0]]++;
+            sub_histograms[1][batch_codes[k + 1]]++;
+            sub_histograms[2][batch_codes[k + 2]]++;
+            sub_histograms[3][batch_codes[k + 3]]++;
+        }
+    }
+
+    for (int i = 0; i < FEEDBACK_CODE_COUNT; ++i) {
+        histogram[i] = sub_histograms[0][i] + sub_histograms[1][i] + sub_histograms[2][i] + sub_histograms[3][i];
+    }
+
+    // zero padding lanes all landed in code 0
+    histogram[0] -= (int)(num_batches * BATCH_SIZE - words);
+}
@@ -0,0 +1,148 @@
+#include "feedbackpattern.hpp"
+#include "words.h"
+
+#include <array>
+#include <cstring>
+
+// digit for guess position i is present_i + correct_i (correct implies present)
+// so each lane's code is the weight 3^i added once under each k-mask
+// present anywhere is Wordle's rule as long as the guess has no repeated letter
+static inline __m512i feedbackCodeBatch(const std::array<__m512i, 5>& zmm_word_char_cols, const std::array<__m512i, 5>& zmm_guess_chars_bcast, const std::array<__m512i, 5>& zmm_digit_weights) {
+    __m512i zmm_code = _mm512_setzero_si512();
+
+    for (int i = 0; i < 5; ++i) {
+        __mmask64 k_correct = _mm512_cmpeq_epi8_mask(zmm_word_char_cols[i], zmm_guess_chars_bcast[i]);
+
+        __mmask64 k_present = k_correct;
+        for (int k = 0; k < 5; ++k) {
+            if (k == i) continue;
+            k_present = _kor_mask64(k_present, _mm512_cmpeq_epi8_mask(zmm_word_char_cols[k], zmm_guess_chars_bcast[i]));
+        }
+
+        zmm_code = _mm512_mask_add_epi8(zmm_code, k_present, zmm_code, zmm_digit_weights[i]);
+        zmm_code = _mm512_mask_add_epi8(zmm_code, k_correct, zmm_code, zmm_digit_weights[i]);
+    }
+
+    return zmm_code;
+}
+
+// Wordle's repeated letter rule, for guesses that repeat a letter
+// guess position i is misplaced only while the answer has more copies of its letter off the greens
+// than earlier positions with the same letter already took
+static inline __m512i feedbackCodeBatchRepeated(const std::array<__m512i, 5>& zmm_word_char_cols, const std::array<__m512i, 5>& zmm_guess_chars_bcast, const std::array<__m512i, 5>& zmm_digit_weights, const char* guess) {
+    __m512i zmm_code = _mm512_setzero_si512();
+    __m512i zmm_zero = _mm512_setzero_si512();
+    __m512i zmm_one = _mm512_set1_epi8(1);
+    std::array<__mmask64, 5> k_correct;
+    std::array<__mmask64, 5> k_misplaced;
+
+    for (int j = 0; j < 5; ++j) {
+        k_correct[j] = _mm512_cmpeq_epi8_mask(zmm_word_char_cols[j], zmm_guess_chars_bcast[j]);
+    }
+
+    for (int i = 0; i < 5; ++i) {
+        __m512i zmm_unmatched = zmm_zero;
+        for (int k = 0; k < 5; ++k) {
+            __mmask64 k_copy = _kandn_mask64(k_correct[k], _mm512_cmpeq_epi8_mask(zmm_word_char_cols[k], zmm_guess_chars_bcast[i]));
+            zmm_unmatched = _mm512_mask_add_epi8(zmm_unmatched, k_copy, zmm_unmatched, zmm_one);
+        }
+        for (int k = 0; k < i; ++k) {
+            if (guess[k] == guess[i]) zmm_unmatched = _mm512_mask_sub_epi8(zmm_unmatched, k_misplaced[k], zmm_unmatched, zmm_one);
+        }
+        k_misplaced[i] = _kandn_mask64(k_correct[i], _mm512_cmpgt_epi8_mask(zmm_unmatched, zmm_zero));
+
+        zmm_code = _mm512_mask_add_epi8(zmm_code, k_misplaced[i], zmm_code, zmm_digit_weights[i]);
+        zmm_code = _mm512_mask_add_epi8(zmm_code, k_correct[i], zmm_code, _mm512_add_epi8(zmm_digit_weights[i], zmm_digit_weights[i]));
+    }
+
+    return zmm_code;
+}
+
+static inline bool hasRepeatedLetter(const char* guess) {
+    for (int i = 0; i < 5; ++i) {
+        for (int k = i + 1; k < 5; ++k) {
+            if (guess[k] == guess[i]) return true;
+        }
+    }
+    return false;
+}
+
+static inline void loadFeedbackGuess(const char* guess, std::array<__m512i, 5>& zmm_guess_chars_bcast, std::array<__m512i, 5>& zmm_digit_weights) {
+    int weight = 1;
+    for (int i = 0; i < 5; ++i) {
+        zmm_guess_chars_bcast[i] = _mm512_set1_epi8(guess[i]);
+        zmm_digit_weights[i] = _mm512_set1_epi8((char)weight);
+        weight *= 3;
+    }
+}
+
+void hyperpacked_feedbackCodes_AVX512(const char* guess, const unsigned char* hyperpacked_wordlist, size_t words, unsigned char* codes) {
+    const int BATCH_SIZE = 64;
+    std::array<__m512i, 5> zmm_guess_chars_bcast;
+    std::array<__m512i, 5> zmm_digit_weights;
+    std::array<__m512i, 5> zmm_word_char_cols;
+    loadFeedbackGuess(guess, zmm_guess_chars_bcast, zmm_digit_weights);
+    bool repeats = hasRepeatedLetter(guess);
+
+    size_t num_batches = (words + BATCH_SIZE - 1) / BATCH_SIZE;
+
+    for (size_t batch_idx = 0; batch_idx < num_batches; ++batch_idx) {
+        size_t soa_batch_base_offset = batch_idx * 5 * BATCH_SIZE;
+
+        for (int j = 0; j < 5; ++j) {
+            zmm_word_char_cols[j] = _mm512_loadu_si512(
+                reinterpret_cast<const void*>(&hyperpacked_wordlist[soa_batch_base_offset + j * BATCH_SIZE])
+            );
+        }
+
+        _mm512_storeu_si512(
+            reinterpret_cast<void*>(&codes[batch_idx * BATCH_SIZE]),
+            (repeats ? feedbackCodeBatchRepeated(zmm_word_char_cols, zmm_guess_chars_bcast, zmm_digit_weights, guess) : feedbackCodeBatch(zmm_word_char_cols, zmm_guess_chars_bcast, zmm_digit_weights))
+        );
+    }
+}
+
+void hyperpacked_feedbackHistogram_AVX512(const char* guess, const unsigned char* hyperpacked_wordlist, size_t words, int* histogram) {
+    const int BATCH_SIZE = 64;
+    std::array<__m512i, 5> zmm_guess_chars_bcast;
+    std::array<__m512i, 5> zmm_digit_weights;
+    std::array<__m512i, 5> zmm_word_char_cols;
+    loadFeedbackGuess(guess, zmm_guess_chars_bcast, zmm_digit_weights);
+    bool repeats = hasRepeatedLetter(guess);
+
+    // 4 interleaved counters so repeated codes don't serialize on one store
+    int sub_histograms[4][256];
+    std::memset(sub_histograms, 0, sizeof(sub_histograms));
+    alignas(64) unsigned char batch_codes[BATCH_SIZE];
+
+    size_t num_batches = (words + BATCH_SIZE - 1) / BATCH_SIZE;
+
+    for (size_t batch_idx = 0; batch_idx < num_batches; ++batch_idx) {
+        size_t soa_batch_base_offset = batch_idx * 5 * BATCH_SIZE;
+
+        for (int j = 0; j < 5; ++j) {
+            zmm_word_char_cols[j] = _mm512_loadu_si512(
+                reinterpret_cast<const void*>(&hyperpacked_wordlist[soa_batch_base_offset + j * BATCH_SIZE])
+            );
+        }
+
+        _mm512_store_si512(
+            reinterpret_cast<void*>(batch_codes),
+            (repeats ? feedbackCodeBatchRepeated(zmm_word_char_cols, zmm_guess_chars_bcast, zmm_digit_weights, guess) : feedbackCodeBatch(zmm_word_char_cols, zmm_guess_chars_bcast, zmm_digit_weights))
+        );
+
+        for (int k = 0; k < BATCH_SIZE; k += 4) {
+            sub_histograms[0][batch_codes[k + 0]]++;
+            sub_histograms[1][batch_codes[k + 1]]++;
+            sub_histograms[2][batch_codes[k + 2]]++;
+            sub_histograms[3][batch_codes[k + 3]]++;
+        }
+    }
+
+    for (int i = 0; i < FEEDBACK_CODE_COUNT; ++i) {
+        histogram[i] = sub_histograms[0][i] + sub_histograms[1][i] + sub_histograms[2][i] + sub_histograms[3][i];
+    }
+
+    // zero padding lanes all landed in code 0
+    histogram[0] -= (int)(num_batches * BATCH_SIZE - words);
+}
@@ -0,0 +1,129 @@
+#include "gamesession.hpp"
+#include "words.h"
+
+#include <cstring>
+
+void GameSession::AlignedFree::operator()(unsigned char* mem) const {
+    _aligned_free(mem);
+}
+
+GameSession::GameSession(const std::vector<std::string>& dictionary, SimdLevel simdLevel) {
+    this->simdLevel = simdLevel;
+    this->packwidth = simdLevelPackWidth(simdLevel);
+
+    this->dictionaryWords.resize(dictionary.size() * 5);
+    for (int i = 0; i < dictionary.size(); i++) {
+        std::memcpy(&(this->dictionaryWords[i * 5]), dictionary[i].c_str(), 5);
+    }
+
+    this->reset();
+}
+
+size_t GameSession::packedBytes(size_t words) const {
+    if (this->packwidth == 0) return words * 5;
+
+    //same padding main uses, always at least one zeroed batch
+    return ((words / this->packwidth) + 1) * this->packwidth * 5;
+}
+
+GameSession::PackedBuffer GameSession::pack(const std::vector<int>& candidateIdxs) const {
+    size_t bytes = this->packedBytes(candidateIdxs.size());
+    PackedBuffer packed{ (unsigned char*)_aligned_malloc(bytes == 0 ? 64 : bytes, 64) };
+    std::memset(packed.get(), 0, bytes);
+
+    const unsigned char* words = this->dictionaryWords.data();
+    if (this->packwidth == 0) {
+        for (size_t i = 0; i < candidateIdxs.size(); i++) {
+            std::memcpy(&(packed[i * 5]), &(words[candidateIdxs[i] * 5]), 5);
+        }
+    }
+    else {
+        //[w0c0], [w1c0], ... one row per letter, packwidth words per batch
+        for (size_t i = 0; i < candidateIdxs.size(); i++) {
+            size_t batch = i / this->packwidth;
+            size_t lane = i % this->packwidth;
+            const unsigned char* word = &(words[candidateIdxs[i] * 5]);
+            for (int j = 0; j < 5; j++) {
+                packed[(batch * 5 + j) * this->packwidth + lane] = word[j];
+            }
+        }
+    }
+
+    return packed;
+}
+
+void GameSession::reset() {
+    this->turns.clear();
+
+    Turn start;
+    start.candidateIdxs.resize(this->dictionaryWords.size() / 5);
+    for (int i = 0; i < start.candidateIdxs.size(); i++) {
+        start.candidateIdxs[i] = i;
+    }
+    start.packed = this->pack(start.candidateIdxs);
+
+    this->turns.push_back(std::move(start));
+}
+
+size_t GameSession::applyFeedback(const char* guess, unsigned char pattern) {
+    const Turn& current = this->turns.back();
+    size_t words = current.candidateIdxs.size();
+
+    //codes for every current candidate, padded to the batch size for the simd kernels
+    this->codeScratch.resize(words + 64);
+    unsigned char* codes = this->codeScratch.data();
+
+    switch (this->simdLevel) {
+    case SimdLevel::AVX512:
+        hyperpacked_feedbackCodes_AVX512(guess, current.packed.get(), words, codes);
+        break;
+    case SimdLevel::AVX2:
+        hyperpacked_feedbackCodes(guess, current.packed.get(), words, codes);
+        break;
+    default:
+        for (size_t i = 0; i < words; i++) {
+            codes[i] = computeFeedbackCode((const char*)&(current.packed[i * 5]), guess);
+        }
+        break;
+    }
+
+    Turn next;
+    next.candidateIdxs.reserve(words);
+    for (size_t i = 0; i < words; i++) {
+        if (codes[i] == pattern) next.candidateIdxs.push_back(current.candidateIdxs[i]);
+    }
+    next.packed = this->pack(next.candidateIdxs);
+
+    this->turns.push_back(std::move(next));
+    return this->size();
+}
+
+bool GameSession::undo() {
+    if (this->turns.size() <= 1) return false;
+
+    this->turns.pop_back();
+    return true;
+}
+
+float GameSession::countAvgRemaining(const char* guess) const {
+    int histogram[FEEDBACK_CODE_COUNT];
+    const unsigned char* packed = this->packedCandidates();
+    size_t words = this->size();
+
+    switch (this->simdLevel) {
+    case SimdLevel::AVX512:
+        hyperpacked_feedbackHistogram_AVX512(guess, packed, words, histogram);
+        break;
+    case SimdLevel::AVX2:
+        hyperpacked_feedbackHistogram(guess, packed, words, histogram);
+        break;
+    default:
+        std::memset(histogram, 0, sizeof(histogram));
+        for (size_t i = 0; i < words; i++) {
+            histogram[computeFeedbackCode((const char*)&(packed[i * 5]), guess)]++;
+        }
+        break;
+    }
+
+    return histogramAvgRemaining(histogram, words);
+}
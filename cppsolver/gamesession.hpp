@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+
+#include "cpufeatures.hpp"
+#include "feedbackpattern.hpp"
+
+// candidate set for one game, narrowed turn by turn
+// every turn keeps its own candidate list and packed buffer, so undo just drops the last one
+// and each turn only touches the candidates left after the previous one
+class GameSession {
+public:
+    GameSession(const std::vector<std::string>& dictionary, SimdLevel simdLevel);
+
+    // keeps the candidates that would have given pattern (see computeFeedbackCode) for guess
+    // returns the number of candidates left
+    size_t applyFeedback(const char* guess, unsigned char pattern);
+    // false if there is no turn to undo
+    bool undo();
+    void reset();
+
+    size_t size() const { return this->turns.back().candidateIdxs.size(); }
+    int getTurnCount() const { return (int)this->turns.size() - 1; }
+
+    // indexes into the dictionary, in dictionary order
+    const std::vector<int>& candidates() const { return this->turns.back().candidateIdxs; }
+    const char* candidateWord(size_t i) const { return (const char*)&(this->dictionaryWords[this->candidates()[i] * 5]); }
+
+    // hyperpacked (getPackWidth() bytes per row) for AVX2/AVX-512, flat 5 bytes per word otherwise
+    const unsigned char* packedCandidates() const { return this->turns.back().packed.get(); }
+    int getPackWidth() const { return this->packwidth; }
+
+    // expected remaining candidates after guessing guess, with the session's kernel
+    float countAvgRemaining(const char* guess) const;
+
+private:
+    struct AlignedFree {
+        void operator()(unsigned char* mem) const;
+    };
+    using PackedBuffer = std::unique_ptr<unsigned char[], AlignedFree>;
+
+    struct Turn {
+        std::vector<int> candidateIdxs;
+        PackedBuffer packed;
+    };
+
+    PackedBuffer pack(const std::vector<int>& candidateIdxs) const;
+    size_t packedBytes(size_t words) const;
+
+    SimdLevel simdLevel;
+    int packwidth;
+    std::vector<unsigned char> dictionaryWords; //flat, 5 bytes per word
+    std::vector<Turn> turns; //turns[0] is the whole dictionary
+
+    std::vector<unsigned char> codeScratch;
+};
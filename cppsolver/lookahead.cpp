@@ -0,0 +1,57 @@
+#include "lookahead.hpp"
+#include "cpufeatures.hpp"
+#include "words.h"
+
+#include <algorithm>
+
+float followUpGuesses(const FeedbackLookup& lookup, size_t searchWords, const int* answerIdxs, size_t count) {
+    if (count <= 2) return candidateGuesses(count);
+
+    //nothing beats splitting every candidate apart with a guess that can be the answer
+    const int bestPossible = (int)count + 1;
+
+    int best = 0;
+    for (size_t guessIdx = 0; guessIdx < searchWords && best < bestPossible; guessIdx++) {
+        uint64_t seen[(FEEDBACK_CODE_COUNT + 63) / 64] = {};
+        for (size_t i = 0; i < count; i++) {
+            unsigned char code = lookup.code(guessIdx, answerIdxs[i]);
+            seen[code >> 6] |= 1ULL << (code & 63);
+        }
+
+        int buckets = 0;
+        for (uint64_t bits : seen) buckets += portablePopcount(bits);
+        int canSolve = (int)((seen[SOLVED_FEEDBACK_CODE >> 6] >> (SOLVED_FEEDBACK_CODE & 63)) & 1);
+
+        best = std::max(best, buckets + canSolve);
+    }
+
+    return 1.0f + (2.0f * count - best) / count;
+}
+
+CandidateBitset candidateBitset(const std::vector<int>& answerIdxs, size_t answers) {
+    CandidateBitset bits((answers + 63) / 64, 0);
+    for (int idx : answerIdxs) bits[idx >> 6] |= 1ULL << (idx & 63);
+    return bits;
+}
+
+bool TranspositionCache::find(const CandidateBitset& key, float& value) const {
+    auto found = this->entries.find(key);
+    if (found == this->entries.end()) return false;
+    value = found->second;
+    return true;
+}
+
+void TranspositionCache::insert(CandidateBitset key, float value) {
+    if (this->entries.size() >= this->capacity) this->entries.clear();
+    this->entries.emplace(std::move(key), value);
+}
+
+size_t TranspositionCache::BitsetHash::operator()(const CandidateBitset& bits) const {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (uint64_t word : bits) {
+        hash ^= word;
+        hash *= 0x100000001b3ULL;
+        hash ^= hash >> 29;
+    }
+    return (size_t)hash;
+}
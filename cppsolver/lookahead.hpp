@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <unordered_map>
+
+#include "feedbackpattern.hpp"
+#include "patternmatrix.hpp"
+
+struct LookaheadConfig {
+    // how many of the best one ply guesses get a second ply
+    int firstGuesses = 10;
+    // seconds, guesses not expanded by then keep only their one ply score, 0 for no limit
+    // checked between first guesses, so the best one is always expanded
+    double timeBudget = 0.0;
+};
+
+struct LookaheadGuess {
+    int guessIdx;          // index into the search words
+    float onePlyScore;     // the first ply metric's value, see metricValue
+    float expectedGuesses; // expected guesses to solve, counting this one, infinity if not expanded
+    bool expanded;
+};
+
+// feedback code of a search word against an answer word
+// read from the pattern matrix when the solver has one, computed otherwise
+struct FeedbackLookup {
+    const PatternMatrix* matrix;   // nullptr if unused
+    const PatternWordlist* answers;
+    const std::vector<std::string>* searchWords;
+
+    unsigned char code(size_t guessIdx, int answerIdx) const {
+        if (this->matrix != nullptr) return this->matrix->code(guessIdx, answerIdx);
+        return this->answers->feedbackCode(answerIdx, (*this->searchWords)[guessIdx].c_str());
+    }
+};
+
+// expected guesses still needed for the count answers in answerIdxs, picking the best next guess out of
+// every search word and assuming each bucket it leaves is then solved as fast as possible:
+// one guess for 1 candidate, (2k - 1) / k for k (guess a candidate, the one after is always right)
+// that sums to 1 + (2k - s - b) / k for a guess leaving b distinct codes, s = 1 if it can be the answer
+float followUpGuesses(const FeedbackLookup& lookup, size_t searchWords, const int* answerIdxs, size_t count);
+
+// the same value without a search, for the sets that can't do better than guessing a candidate (2 or less)
+inline float candidateGuesses(size_t count) {
+    return (count == 0) ? 0.0f : (2.0f * count - 1.0f) / count;
+}
+
+// candidate set as a bitset over the answer list
+using CandidateBitset = std::vector<uint64_t>;
+CandidateBitset candidateBitset(const std::vector<int>& answerIdxs, size_t answers);
+
+// followUpGuesses results keyed by candidate set
+// the same buckets come up under many first guesses and again on later turns, and a solver's
+// search words never change, so entries stay valid for its lifetime
+class TranspositionCache {
+public:
+    explicit TranspositionCache(size_t capacity = 1 << 16) : capacity{ capacity } {}
+
+    bool find(const CandidateBitset& key, float& value) const;
+    // the whole cache is dropped once it holds capacity entries
+    void insert(CandidateBitset key, float value);
+    size_t size() const { return this->entries.size(); }
+
+private:
+    struct BitsetHash {
+        size_t operator()(const CandidateBitset& bits) const;
+    };
+
+    std::unordered_map<CandidateBitset, float, BitsetHash> entries;
+    size_t capacity;
+};
@@ -0,0 +1,73 @@
+#include "multiboard.hpp"
+#include "cpufeatures.hpp"
+#include "words.h"
+
+#include <algorithm>
+#include <cstring>
+
+MultiBoardCandidates::MultiBoardCandidates(const std::vector<std::vector<int>>& boards) {
+    //merge the boards on answer index, the lists are sorted so equal answers meet
+    std::vector<std::pair<int, uint32_t>> tagged;
+    for (const std::vector<int>& board : boards) {
+        if (board.empty()) continue;
+
+        uint32_t bit = 1u << this->boardSizes.size();
+        for (int answerIdx : board) tagged.emplace_back(answerIdx, bit);
+        this->boardSizes.push_back(board.size());
+        if (this->boardSizes.size() == MAX_BOARDS) break;
+    }
+    std::sort(tagged.begin(), tagged.end());
+
+    for (const std::pair<int, uint32_t>& answer : tagged) {
+        if (!this->answerIdxs.empty() && this->answerIdxs.back() == answer.first) {
+            this->boardMasks.back() |= answer.second;
+        }
+        else {
+            this->answerIdxs.push_back(answer.first);
+            this->boardMasks.push_back(answer.second);
+        }
+    }
+}
+
+MultiBoardGuess MultiBoardCandidates::score(const FeedbackLookup& lookup, int guessIdx) const {
+    const int boards = this->getBoardCount();
+
+    int histograms[MAX_BOARDS][FEEDBACK_CODE_COUNT];
+    std::memset(histograms, 0, sizeof(histograms[0]) * boards);
+    int64_t sumSquares[MAX_BOARDS] = {};
+    uint32_t solvedBoards = 0;
+
+    for (size_t i = 0; i < this->answerIdxs.size(); i++) {
+        unsigned char code = lookup.code(guessIdx, this->answerIdxs[i]);
+        uint32_t mask = this->boardMasks[i];
+        if (code == SOLVED_FEEDBACK_CODE) solvedBoards |= mask;
+
+        //(h + 1)^2 - h^2 = 2h + 1
+        for (uint32_t m = mask; m != 0; m &= m - 1) {
+            int board = lowestSetBit(m);
+            int& bucket = histograms[board][code];
+            sumSquares[board] += 2 * bucket + 1;
+            bucket++;
+        }
+    }
+
+    //the boards' answers are independent, a candidate guess solves its board with chance 1 / n
+    float expectedRemaining = 0.0f;
+    float noneSolved = 1.0f;
+    for (int board = 0; board < boards; board++) {
+        expectedRemaining += (float)sumSquares[board] / (float)this->boardSizes[board];
+        if ((solvedBoards >> board) & 1) noneSolved *= 1.0f - 1.0f / (float)this->boardSizes[board];
+    }
+
+    return { guessIdx, 0.0f, expectedRemaining, 1.0f - noneSolved };
+}
+
+float multiBoardObjectiveValue(const MultiBoardGuess& guess, MultiBoardObjective objective) {
+    return (objective == MultiBoardObjective::SolveAny) ? guess.solveAnyChance : guess.expectedRemaining;
+}
+
+bool multiBoardRanksBefore(const MultiBoardGuess& a, const MultiBoardGuess& b, MultiBoardObjective objective) {
+    if (objective == MultiBoardObjective::SolveAny && a.solveAnyChance != b.solveAnyChance) return a.solveAnyChance > b.solveAnyChance;
+    if (a.expectedRemaining != b.expectedRemaining) return a.expectedRemaining < b.expectedRemaining;
+    return a.guessIdx < b.guessIdx;
+}
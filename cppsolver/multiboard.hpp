@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "lookahead.hpp"
+
+// most unsolved boards one ranking takes, board membership is a 32 bit mask per answer
+constexpr int MAX_BOARDS = 32;
+
+// ways to rank a guess over several boards (Quordle, Octordle) played at once
+enum class MultiBoardObjective {
+    SumExpected, // candidates expected to be left, summed over the unsolved boards
+    SolveAny     // chance the guess solves at least one board, ties broken by SumExpected
+};
+
+struct MultiBoardGuess {
+    int guessIdx;            // index into the search words
+    float score;             // the objective's value
+    float expectedRemaining; // SumExpected
+    float solveAnyChance;    // SolveAny
+};
+
+// candidates of every unsolved board merged into one list, so a guess codes each distinct answer once
+// and adds the code to the histogram of every board still holding that answer
+class MultiBoardCandidates {
+public:
+    // boards hold answer list indexes, each ascending, empty boards are solved and left out
+    // at most MAX_BOARDS boards may be unsolved
+    explicit MultiBoardCandidates(const std::vector<std::vector<int>>& boards);
+
+    // distinct answers over the unsolved boards
+    size_t size() const { return this->answerIdxs.size(); }
+    int getBoardCount() const { return (int)this->boardSizes.size(); }
+
+    // score is left for the ranking to fill in
+    MultiBoardGuess score(const FeedbackLookup& lookup, int guessIdx) const;
+
+private:
+    std::vector<int> answerIdxs;      // ascending
+    std::vector<uint32_t> boardMasks; // unsolved boards holding each answer
+    std::vector<size_t> boardSizes;
+};
+
+float multiBoardObjectiveValue(const MultiBoardGuess& guess, MultiBoardObjective objective);
+// true if a ranks ahead of b
+bool multiBoardRanksBefore(const MultiBoardGuess& a, const MultiBoardGuess& b, MultiBoardObjective objective);
@@ -0,0 +1,154 @@
+#include "numatopology.hpp"
+#include "words.h"
+
+#include <vector>
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sched.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <fstream>
+#include <cstdio>
+#endif
+
+static constexpr size_t hugePageSize = 2 * 1024 * 1024;
+
+static size_t roundUp(size_t size, size_t multiple) {
+    return ((size + multiple - 1) / multiple) * multiple;
+}
+
+#ifdef _WIN32
+
+int numaNodeCount() {
+    ULONG highest = 0;
+    if (!GetNumaHighestNodeNumber(&highest)) return 1;
+    return (int)highest + 1;
+}
+
+bool pinCurrentThreadToNumaNode(int node) {
+    GROUP_AFFINITY affinity{};
+    if (!GetNumaNodeProcessorMaskEx((USHORT)node, &affinity) || affinity.Mask == 0) return false;
+    return SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr) != 0;
+}
+
+void* allocateNodeMemory(size_t size, int node, bool hugePages, size_t& allocatedSize, bool& usedHugePages) {
+    usedHugePages = false;
+
+    //large pages need SeLockMemoryPrivilege, fall through to normal pages without it
+    size_t largePage = GetLargePageMinimum();
+    if (hugePages && largePage != 0) {
+        allocatedSize = roundUp(size, largePage);
+        void* mem = VirtualAllocExNuma(GetCurrentProcess(), nullptr, allocatedSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE, (DWORD)node);
+        if (mem != nullptr) {
+            usedHugePages = true;
+            return mem;
+        }
+    }
+
+    allocatedSize = size;
+    return VirtualAllocExNuma(GetCurrentProcess(), nullptr, allocatedSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, (DWORD)node);
+}
+
+void freeNodeMemory(void* mem, size_t allocatedSize) {
+    if (mem != nullptr) VirtualFree(mem, 0, MEM_RELEASE);
+}
+
+#else
+
+//node ids with a cpulist under sysfs, contiguous on every machine we run on
+static std::vector<std::vector<int>> readNodeCpus() {
+    std::vector<std::vector<int>> nodes;
+    for (int node = 0; ; node++) {
+        std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!in) break;
+
+        //format: 0-15,32-47
+        std::vector<int> cpus;
+        std::string range;
+        while (std::getline(in, range, ',')) {
+            int first = 0, last = 0;
+            int fields = std::sscanf(range.c_str(), "%d-%d", &first, &last);
+            if (fields < 1) continue;
+            if (fields == 1) last = first;
+            for (int cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+        }
+        nodes.push_back(cpus);
+    }
+    return nodes;
+}
+
+static const std::vector<std::vector<int>>& nodeCpus() {
+    static const std::vector<std::vector<int>> nodes = readNodeCpus();
+    return nodes;
+}
+
+int numaNodeCount() {
+    return nodeCpus().empty() ? 1 : (int)nodeCpus().size();
+}
+
+bool pinCurrentThreadToNumaNode(int node) {
+    if (node < 0 || node >= (int)nodeCpus().size() || nodeCpus()[node].empty()) return false;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : nodeCpus()[node]) {
+        if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+//MPOL_PREFERRED from linux/mempolicy.h, through the raw syscall so there is no libnuma dependency
+static constexpr int preferredPolicy = 1;
+
+//asks the kernel to place the pages of mem on node when they are first touched, other nodes if it is full
+//best effort: without the syscall (or on a single node host) placement is still first touch, and callers fill
+//the memory from a thread pinned to node
+static void preferNode(void* mem, size_t size, int node) {
+#ifdef SYS_mbind
+    if (node < 0 || node >= numaNodeCount() || node >= 64) return;
+    unsigned long nodemask = 1ul << node;
+    syscall(SYS_mbind, mem, size, preferredPolicy, &nodemask, sizeof(nodemask) * 8, 0);
+#else
+    (void)mem; (void)size; (void)node;
+#endif
+}
+
+void* allocateNodeMemory(size_t size, int node, bool hugePages, size_t& allocatedSize, bool& usedHugePages) {
+    usedHugePages = false;
+
+    if (hugePages) {
+        //reserved hugetlbfs pages first, then transparent huge pages
+        allocatedSize = roundUp(size, hugePageSize);
+        void* mem = mmap(nullptr, allocatedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (mem != MAP_FAILED) {
+            usedHugePages = true;
+            preferNode(mem, allocatedSize, node);
+            return mem;
+        }
+
+        mem = mmap(nullptr, allocatedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) return nullptr;
+        usedHugePages = madvise(mem, allocatedSize, MADV_HUGEPAGE) == 0;
+        preferNode(mem, allocatedSize, node);
+        return mem;
+    }
+
+    allocatedSize = size;
+    void* mem = mmap(nullptr, allocatedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) return nullptr;
+    preferNode(mem, allocatedSize, node);
+    return mem;
+}
+
+void freeNodeMemory(void* mem, size_t allocatedSize) {
+    if (mem != nullptr) munmap(mem, allocatedSize);
+}
+
+#endif
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+
+// number of numa nodes, 1 on single socket hosts or when the topology can't be read
+int numaNodeCount();
+
+// restricts the calling thread to the cpus of node (0 based, < numaNodeCount())
+bool pinCurrentThreadToNumaNode(int node);
+
+// page aligned allocation preferring node, backed by 2MB pages when hugePages is set and the OS allows it
+// the size actually mapped is returned through allocatedSize and has to be passed back to freeNodeMemory
+void* allocateNodeMemory(size_t size, int node, bool hugePages, size_t& allocatedSize, bool& usedHugePages);
+void freeNodeMemory(void* mem, size_t allocatedSize);
@@ -0,0 +1,200 @@
+#include "openingbook.hpp"
+#include "patternmatrix.hpp"
+#include "words.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+#include <iterator>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+static const char openingBookMagic[8] = { 'W', 'S', 'O', 'P', 'B', 'O', 'O', 'K' };
+
+static void writeRanking(std::vector<unsigned char>& image, size_t offset, int topK, const std::vector<ScoredGuess>& ranking) {
+    uint32_t count = (uint32_t)std::min(ranking.size(), (size_t)topK);
+    std::memcpy(&image[offset], &count, sizeof(count));
+
+    OpeningBookRecord* records = (OpeningBookRecord*)&image[offset + sizeof(uint32_t)];
+    for (uint32_t i = 0; i < count; i++) {
+        const HistogramMetrics& metrics = ranking[i].metrics;
+        records[i] = { (uint32_t)ranking[i].guessIdx, metrics.worstCase, metrics.sumSquares, metrics.expectedSize, metrics.entropy, metrics.solveNow, metrics.solveNext };
+    }
+}
+
+static std::vector<ScoredGuess> readRanking(const unsigned char* data, int topK, size_t guessCount, ScoringMetric metric) {
+    uint32_t count;
+    std::memcpy(&count, data, sizeof(count));
+    if (count > (uint32_t)topK) return {};
+
+    const OpeningBookRecord* records = (const OpeningBookRecord*)(data + sizeof(uint32_t));
+    std::vector<ScoredGuess> ranking;
+    ranking.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+        if (records[i].guessIdx >= guessCount) return {};
+
+        HistogramMetrics metrics;
+        metrics.sumSquares = records[i].sumSquares;
+        metrics.expectedSize = records[i].expectedSize;
+        metrics.entropy = records[i].entropy;
+        metrics.worstCase = records[i].worstCase;
+        metrics.solveNow = records[i].solveNow;
+        metrics.solveNext = records[i].solveNext;
+        ranking.push_back({ (int)records[i].guessIdx, metricValue(metrics, metric), metrics });
+    }
+    return ranking;
+}
+
+static inline size_t rankingBytes(int topK) {
+    return sizeof(uint32_t) + (size_t)topK * sizeof(OpeningBookRecord);
+}
+
+bool buildOpeningBook(Solver& solver, ScoringMetric metric, int topK, const std::string& path, std::string& error) {
+    const std::vector<std::string>& searchWords = solver.getSearchWords();
+    const std::vector<std::string>& answerWords = solver.getAnswerWords();
+    if (topK <= 0) {
+        error = "opening book needs at least one guess per position";
+        return false;
+    }
+
+    std::vector<unsigned char> image(sizeof(OpeningBookHeader) + (1 + FEEDBACK_CODE_COUNT) * rankingBytes(topK), 0);
+    OpeningBookHeader& header = *((OpeningBookHeader*)image.data());
+    std::memcpy(header.magic, openingBookMagic, sizeof(openingBookMagic));
+    header.version = OPENING_BOOK_VERSION;
+    header.headerSize = sizeof(OpeningBookHeader);
+    header.guessCount = (uint32_t)searchWords.size();
+    header.answerCount = (uint32_t)answerWords.size();
+    header.topK = (uint32_t)topK;
+    header.metric = (uint32_t)metric;
+    header.listHash = hashWordLists(searchWords, answerWords);
+
+    std::vector<ScoredGuess> firstTurn = solver.rankGuesses(answerWords, topK, metric);
+    if (firstTurn.empty()) {
+        error = "no guesses to rank";
+        return false;
+    }
+    writeRanking(image, sizeof(OpeningBookHeader), topK, firstTurn);
+
+    //every feedback the best first guess can get, each one a live ranking on the pool
+    const char* firstGuess = searchWords[firstTurn[0].guessIdx].c_str();
+    std::vector<std::vector<std::string>> buckets(FEEDBACK_CODE_COUNT);
+    for (const std::string& answer : answerWords) {
+        buckets[computeFeedbackCode(answer.c_str(), firstGuess)].push_back(answer);
+    }
+    for (int code = 0; code < FEEDBACK_CODE_COUNT; code++) {
+        if (buckets[code].empty()) continue;
+        writeRanking(image, sizeof(OpeningBookHeader) + (1 + code) * rankingBytes(topK), topK, solver.rankGuesses(buckets[code], topK, metric));
+    }
+
+    //write under a per process name and rename so nothing ever loads a half written book
+#ifdef _WIN32
+    std::string tempPath = path + ".tmp" + std::to_string(_getpid());
+#else
+    std::string tempPath = path + ".tmp" + std::to_string(getpid());
+#endif
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        out.write((const char*)image.data(), image.size());
+        if (!out) {
+            out.close();
+            std::error_code ec;
+            std::filesystem::remove(tempPath, ec);
+            error = "could not write " + tempPath;
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+        error = "could not replace " + path;
+        return false;
+    }
+    return true;
+}
+
+bool OpeningBook::load(const std::string& path, const std::vector<std::string>& guesses, const std::vector<std::string>& answers, std::string& error) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        error = "could not open " + path;
+        return false;
+    }
+    std::vector<unsigned char> image((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    //validate before trusting any of it
+    if (image.size() < sizeof(OpeningBookHeader)) {
+        error = path + " is not an opening book";
+        return false;
+    }
+    const OpeningBookHeader& header = *((const OpeningBookHeader*)image.data());
+    if (std::memcmp(header.magic, openingBookMagic, sizeof(openingBookMagic)) != 0 ||
+        header.version != OPENING_BOOK_VERSION ||
+        header.headerSize != sizeof(OpeningBookHeader) ||
+        header.topK == 0 ||
+        header.metric > (uint32_t)ScoringMetric::SolveNext ||
+        image.size() != sizeof(OpeningBookHeader) + (1 + FEEDBACK_CODE_COUNT) * rankingBytes(header.topK)
+    ) {
+        error = path + " is not an opening book";
+        return false;
+    }
+    if (header.guessCount != guesses.size() || header.answerCount != answers.size() || header.listHash != hashWordLists(guesses, answers)) {
+        error = path + " was built from other word lists";
+        return false;
+    }
+
+    ScoringMetric metric = (ScoringMetric)header.metric;
+    int topK = (int)header.topK;
+    std::vector<ScoredGuess> firstTurn = readRanking(&image[sizeof(OpeningBookHeader)], topK, guesses.size(), metric);
+    if (firstTurn.empty()) {
+        error = path + " has no first turn";
+        return false;
+    }
+
+    this->metric = metric;
+    this->topK = topK;
+    this->answerCount = answers.size();
+    this->firstTurn = std::move(firstTurn);
+    this->secondTurn.resize(FEEDBACK_CODE_COUNT);
+    for (int code = 0; code < FEEDBACK_CODE_COUNT; code++) {
+        this->secondTurn[code] = readRanking(&image[sizeof(OpeningBookHeader) + (1 + code) * rankingBytes(topK)], topK, guesses.size(), metric);
+    }
+
+    const char* firstGuess = guesses[this->firstTurn[0].guessIdx].c_str();
+    this->firstGuessCodes.resize(answers.size());
+    this->bucketSizes.assign(FEEDBACK_CODE_COUNT, 0);
+    for (size_t i = 0; i < answers.size(); i++) {
+        this->firstGuessCodes[i] = computeFeedbackCode(answers[i].c_str(), firstGuess);
+        this->bucketSizes[this->firstGuessCodes[i]]++;
+    }
+    return true;
+}
+
+bool OpeningBook::holdsSetOfSize(size_t count) const {
+    if (this->firstTurn.empty() || count == 0) return false;
+    if (count == this->answerCount) return true;
+    for (size_t size : this->bucketSizes) {
+        if (size == count) return true;
+    }
+    return false;
+}
+
+const std::vector<ScoredGuess>* OpeningBook::find(const int* answerIdxs, size_t count) const {
+    if (this->firstTurn.empty() || count == 0) return nullptr;
+
+    //distinct answers, so as many as there are answers is all of them
+    if (count == this->answerCount) return &(this->firstTurn);
+
+    //and as many as one feedback leaves, all with that feedback, is exactly its bucket
+    unsigned char code = this->firstGuessCodes[answerIdxs[0]];
+    if (this->bucketSizes[code] != count) return nullptr;
+    for (size_t i = 1; i < count; i++) {
+        if (this->firstGuessCodes[answerIdxs[i]] != code) return nullptr;
+    }
+    return this->secondTurn[code].empty() ? nullptr : &(this->secondTurn[code]);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "feedbackpattern.hpp"
+#include "scoringmetrics.hpp"
+#include "solver.hpp"
+
+//2: feedback codes follow Wordle's repeated letter rule
+constexpr uint32_t OPENING_BOOK_VERSION = 2;
+
+//file layout: header, then 1 + FEEDBACK_CODE_COUNT rankings, the first turn followed by the second turn
+//after each feedback to the first turn's best guess
+//a ranking is a uint32 count and topK OpeningBookRecord slots, the first count of them used
+struct OpeningBookHeader {
+    char magic[8]; // "WSOPBOOK"
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t guessCount;
+    uint32_t answerCount;
+    uint32_t topK;
+    uint32_t metric; //ScoringMetric
+    uint64_t listHash; //hashWordLists of the lists it was built from
+    char padding[24];
+};
+static_assert(sizeof(OpeningBookHeader) == 64, "opening book header must stay 64 bytes");
+
+struct OpeningBookRecord {
+    uint32_t guessIdx;
+    int32_t worstCase;
+    int64_t sumSquares;
+    float expectedSize;
+    float entropy;
+    float solveNow;
+    float solveNext;
+};
+static_assert(sizeof(OpeningBookRecord) == 32, "opening book records must stay 32 bytes");
+
+//ranks the first turn and the second turn after every feedback to the best first guess with the solver
+//false with a reason in error if the file can't be written
+bool buildOpeningBook(Solver& solver, ScoringMetric metric, int topK, const std::string& path, std::string& error);
+
+//the first two turns of every game, ranked ahead of time
+//a solver with a book (see Solver::setOpeningBook) answers from it when the candidates match a book position
+class OpeningBook {
+public:
+    OpeningBook() = default;
+
+    //false with a reason in error if the file is missing, malformed or was built from other lists
+    bool load(const std::string& path, const std::vector<std::string>& guesses, const std::vector<std::string>& answers, std::string& error);
+
+    ScoringMetric getMetric() const { return this->metric; }
+    int getTopK() const { return this->topK; }
+
+    //cheap check before find, false if no book position has count candidates
+    bool holdsSetOfSize(size_t count) const;
+    //ranking for the candidates given as distinct answer indexes, nullptr if they aren't a book position
+    const std::vector<ScoredGuess>* find(const int* answerIdxs, size_t count) const;
+
+private:
+    ScoringMetric metric = ScoringMetric::ExpectedSize;
+    int topK = 0;
+    size_t answerCount = 0;
+
+    std::vector<ScoredGuess> firstTurn;
+    std::vector<std::vector<ScoredGuess>> secondTurn; //by feedback code
+    std::vector<unsigned char> firstGuessCodes; //feedback to the first guess, per answer
+    std::vector<size_t> bucketSizes;            //answers per feedback code
+};
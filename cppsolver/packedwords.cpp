@@ -0,0 +1,23 @@
+#include "packedwords.hpp"
+#include "words.h"
+
+PackedWordTables::PackedWordTables(const unsigned char* flat, size_t count, const unsigned char* hyperpacked32, const unsigned char* hyperpacked64) {
+    this->setTables(flat, count, hyperpacked32, hyperpacked64);
+}
+
+void PackedWordTables::setTables(const unsigned char* flat, size_t count, const unsigned char* hyperpacked32, const unsigned char* hyperpacked64) {
+    this->flatWords = flat;
+    this->count = count;
+    this->hyperpacked32 = hyperpacked32;
+    this->hyperpacked64 = hyperpacked64;
+}
+
+const std::vector<std::string>& PackedWordTables::strings() const {
+    std::call_once(this->stringsBuilt, [this]() {
+        this->stringCache.reserve(this->count);
+        for (size_t i = 0; i < this->count; i++) {
+            this->stringCache.emplace_back((const char*)&(this->flatWords[i * 5]), 5);
+        }
+    });
+    return this->stringCache;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <mutex>
+
+// one dictionary word, 5 bytes with no terminator, so an array of them is the flat packed form
+struct PackedWord {
+    char letters[5];
+
+    constexpr PackedWord(const char (&word)[6]) : letters{ word[0], word[1], word[2], word[3], word[4] } {}
+};
+static_assert(sizeof(PackedWord) == 5, "packed words must stay 5 bytes");
+
+// hyperpacked layout used by the AVX2/AVX-512 kernels
+// 5 rows of PackWidth bytes per batch, zero padded, words / PackWidth + 1 batches like the runtime packing
+template <size_t Words, int PackWidth>
+struct HyperpackedWords {
+    static constexpr size_t batches = Words / PackWidth + 1;
+    static constexpr size_t bytes = batches * PackWidth * 5;
+
+    alignas(64) unsigned char data[bytes];
+};
+
+template <int PackWidth, size_t Words>
+constexpr HyperpackedWords<Words, PackWidth> hyperpackWords(const PackedWord (&words)[Words]) {
+    HyperpackedWords<Words, PackWidth> packed{};
+    for (size_t i = 0; i < Words; i++) {
+        for (int j = 0; j < 5; j++) {
+            packed.data[(i / PackWidth) * PackWidth * 5 + j * PackWidth + (i % PackWidth)] = (unsigned char)words[i].letters[j];
+        }
+    }
+    return packed;
+}
+
+// runtime packing for lists of N letter words, the layouts BasicWordFilter<N> reads
+// hyperpacked: N rows of packwidth bytes per batch, zero padded, words / packwidth + 1 batches
+template <int N>
+constexpr size_t hyperpackedListBytes(size_t words, int packwidth) {
+    return (words / packwidth + 1) * packwidth * N;
+}
+
+// out must hold hyperpackedListBytes<N>(wordlist.size(), packwidth) bytes
+template <int N>
+void hyperpackWordList(const std::vector<std::string>& wordlist, int packwidth, unsigned char* out) {
+    std::memset(out, 0, hyperpackedListBytes<N>(wordlist.size(), packwidth));
+    for (size_t i = 0; i < wordlist.size(); i++) {
+        unsigned char* lane = &(out[(i / packwidth) * packwidth * N + (i % packwidth)]);
+        const char* word = wordlist[i].c_str();
+        for (int j = 0; j < N; j++) {
+            lane[j * packwidth] = (unsigned char)word[j];
+        }
+    }
+}
+
+// flat, out must hold wordlist.size() * N bytes
+template <int N>
+void flatpackWordList(const std::vector<std::string>& wordlist, unsigned char* out) {
+    for (size_t i = 0; i < wordlist.size(); i++) {
+        std::memcpy(&(out[i * N]), wordlist[i].c_str(), N);
+    }
+}
+
+// a dictionary in every packed form the kernels read, the tables belong to whoever made this
+// (read only data for the embedded lists, WordlistFile for lists loaded at runtime)
+class PackedWordTables {
+public:
+    PackedWordTables(const unsigned char* flat, size_t count, const unsigned char* hyperpacked32, const unsigned char* hyperpacked64);
+
+    PackedWordTables(const PackedWordTables&) = delete;
+    PackedWordTables& operator=(const PackedWordTables&) = delete;
+
+    size_t size() const { return this->count; }
+
+    // flat, 5 bytes per word
+    const unsigned char* flat() const { return this->flatWords; }
+    // packwidth 32 (AVX2) or 64 (AVX-512), 64 byte aligned
+    const unsigned char* hyperpacked(int packwidth) const { return (packwidth == 64) ? this->hyperpacked64 : this->hyperpacked32; }
+    size_t hyperpackedBytes(int packwidth) const { return hyperpackedListBytes<5>(this->count, packwidth); }
+
+    // std::string copies for the code that takes them, built on first use
+    const std::vector<std::string>& strings() const;
+
+protected:
+    PackedWordTables() = default;
+    void setTables(const unsigned char* flat, size_t count, const unsigned char* hyperpacked32, const unsigned char* hyperpacked64);
+
+private:
+    const unsigned char* flatWords = nullptr;
+    size_t count = 0;
+    const unsigned char* hyperpacked32 = nullptr;
+    const unsigned char* hyperpacked64 = nullptr;
+
+    mutable std::once_flag stringsBuilt;
+    mutable std::vector<std::string> stringCache;
+};
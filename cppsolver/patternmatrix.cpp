@@ -0,0 +1,237 @@
+#include "patternmatrix.hpp"
+#include "words.h"
+
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <process.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static const char patternMatrixMagic[8] = { 'W', 'S', 'P', 'A', 'T', 'M', 'A', 'T' };
+
+//FNV-1a
+static inline void hashBytes(uint64_t& hash, const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+}
+
+uint64_t hashWordLists(const std::vector<std::string>& guesses, const std::vector<std::string>& answers) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    //sizes first so moving a word from one list to the other changes the hash
+    uint64_t sizes[2] = { guesses.size(), answers.size() };
+    hashBytes(hash, sizes, sizeof(sizes));
+
+    for (const std::string& word : guesses) hashBytes(hash, word.c_str(), 5);
+    for (const std::string& word : answers) hashBytes(hash, word.c_str(), 5);
+
+    return hash;
+}
+
+PatternMatrix::~PatternMatrix() {
+    this->unmap();
+}
+
+void PatternMatrix::unmap() {
+#ifdef _WIN32
+    if (this->mappedView != nullptr) UnmapViewOfFile(this->mappedView);
+    if (this->mappingHandle != nullptr) CloseHandle(this->mappingHandle);
+    if (this->fileHandle != nullptr) CloseHandle(this->fileHandle);
+    this->mappingHandle = nullptr;
+    this->fileHandle = nullptr;
+#else
+    if (this->mappedView != nullptr) munmap((void*)this->mappedView, this->mappedSize);
+#endif
+    this->mappedView = nullptr;
+    this->mappedSize = 0;
+    this->codes = nullptr;
+}
+
+bool PatternMatrix::mapFile(const std::string& path, uint64_t expectedHash) {
+    this->unmap();
+
+    size_t fileSize = 0;
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart < (LONGLONG)sizeof(PatternMatrixHeader)) {
+        CloseHandle(file);
+        return false;
+    }
+    fileSize = (size_t)size.QuadPart;
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        return false;
+    }
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    this->fileHandle = file;
+    this->mappingHandle = mapping;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(PatternMatrixHeader)) {
+        close(fd);
+        return false;
+    }
+    fileSize = (size_t)st.st_size;
+
+    void* view = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); //the mapping keeps the file alive
+    if (view == MAP_FAILED) return false;
+#endif
+    this->mappedView = view;
+    this->mappedSize = fileSize;
+
+    //validate before trusting any of it
+    const PatternMatrixHeader& header = *((const PatternMatrixHeader*)view);
+    if (std::memcmp(header.magic, patternMatrixMagic, sizeof(patternMatrixMagic)) != 0 ||
+        header.version != PATTERN_MATRIX_VERSION ||
+        header.headerSize != sizeof(PatternMatrixHeader) ||
+        header.guessCount != this->guessCount ||
+        header.answerCount != this->answerCount ||
+        header.listHash != expectedHash ||
+        fileSize != sizeof(PatternMatrixHeader) + this->guessCount * this->answerCount
+    ) {
+        this->unmap();
+        return false;
+    }
+
+    this->codes = (const unsigned char*)view + sizeof(PatternMatrixHeader);
+    return true;
+}
+
+bool PatternMatrix::openOrBuild(const std::string& path, const std::vector<std::string>& guesses, const std::vector<std::string>& answers, size_t maxBytes) {
+    this->unmap();
+    this->ownedCodes.clear();
+    this->guessCount = 0;
+    this->answerCount = 0;
+
+    //millions of answers would take tens of GB, callers compute the codes instead
+    if (!fits(guesses.size(), answers.size(), maxBytes)) return false;
+
+    this->guessCount = guesses.size();
+    this->answerCount = answers.size();
+    uint64_t listHash = hashWordLists(guesses, answers);
+
+    if (this->mapFile(path, listHash)) return true;
+
+    //missing or stale, build the table
+    std::cerr << "building pattern matrix " << path << std::endl;
+
+    PatternWordlist answerList{ answers };
+    this->ownedCodes.resize(this->guessCount * this->answerCount);
+    for (size_t i = 0; i < this->guessCount; i++) {
+        unsigned char* out = &(this->ownedCodes[i * this->answerCount]);
+        for (size_t j = 0; j < this->answerCount; j++) {
+            out[j] = answerList.feedbackCode(j, guesses[i].c_str());
+        }
+    }
+
+    PatternMatrixHeader header{};
+    std::memcpy(header.magic, patternMatrixMagic, sizeof(patternMatrixMagic));
+    header.version = PATTERN_MATRIX_VERSION;
+    header.guessCount = (uint32_t)this->guessCount;
+    header.answerCount = (uint32_t)this->answerCount;
+    header.headerSize = sizeof(PatternMatrixHeader);
+    header.listHash = listHash;
+
+    //write under a per process name and rename so other processes never map a half written file
+#ifdef _WIN32
+    std::string tempPath = path + ".tmp" + std::to_string(_getpid());
+#else
+    std::string tempPath = path + ".tmp" + std::to_string(getpid());
+#endif
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        out.write((const char*)&header, sizeof(header));
+        out.write((const char*)this->ownedCodes.data(), this->ownedCodes.size());
+        if (!out) {
+            out.close();
+            std::error_code ec;
+            std::filesystem::remove(tempPath, ec);
+            this->codes = this->ownedCodes.data();
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+        this->codes = this->ownedCodes.data();
+        return false;
+    }
+
+    if (!this->mapFile(path, listHash)) {
+        this->codes = this->ownedCodes.data();
+        return false;
+    }
+
+    //the mapping replaces the built copy
+    std::vector<unsigned char>().swap(this->ownedCodes);
+    return true;
+}
+
+void PatternMatrix::buildHistogram(size_t guessIdx, const int* answerIdxs, size_t answers, int* histogram) const {
+    std::memset(histogram, 0, sizeof(int) * FEEDBACK_CODE_COUNT);
+
+    const unsigned char* guessRow = this->row(guessIdx);
+    if (answerIdxs == nullptr) {
+        for (size_t i = 0; i < answers; i++) {
+            histogram[guessRow[i]]++;
+        }
+    }
+    else {
+        for (size_t i = 0; i < answers; i++) {
+            histogram[guessRow[answerIdxs[i]]]++;
+        }
+    }
+}
+
+int64_t PatternMatrix::accumulateHistogram(size_t guessIdx, const int* answerIdxs, size_t begin, size_t end, int* histogram) const {
+    const unsigned char* guessRow = this->row(guessIdx);
+
+    //(h + 1)^2 - h^2 = 2h + 1
+    int64_t growth = 0;
+    for (size_t i = begin; i < end; i++) {
+        int& bucket = histogram[guessRow[(answerIdxs == nullptr) ? i : answerIdxs[i]]];
+        growth += 2 * bucket + 1;
+        bucket++;
+    }
+    return growth;
+}
+
+float PatternMatrix::countAvgRemaining(size_t guessIdx, const int* answerIdxs, size_t answers) const {
+    if (answers == 0) return 0.0f;
+
+    int histogram[FEEDBACK_CODE_COUNT];
+    this->buildHistogram(guessIdx, answerIdxs, answers, histogram);
+
+    return histogramAvgRemaining(histogram, answers);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "feedbackpattern.hpp"
+
+//2: feedback codes follow Wordle's repeated letter rule
+constexpr uint32_t PATTERN_MATRIX_VERSION = 2;
+//largest table openOrBuild takes on by default, past it the codes are cheaper to compute than to hold
+constexpr size_t PATTERN_MATRIX_DEFAULT_MAX_BYTES = (size_t)2 << 30;
+
+//on disk layout, followed by guessCount * answerCount feedback codes (one row per guess)
+struct PatternMatrixHeader {
+    char magic[8]; // "WSPATMAT"
+    uint32_t version;
+    uint32_t guessCount;
+    uint32_t answerCount;
+    uint32_t headerSize;
+    uint64_t listHash;
+    char padding[32]; //keep the rows 64 byte aligned in the mapping
+};
+static_assert(sizeof(PatternMatrixHeader) == 64, "pattern matrix header must stay 64 bytes");
+
+//hash of both word lists, any change to either list invalidates the file
+uint64_t hashWordLists(const std::vector<std::string>& guesses, const std::vector<std::string>& answers);
+
+//full guess x answer feedback code table
+//memory mapped read only, so every solver process on the host shares the same page cache copy
+class PatternMatrix {
+public:
+    PatternMatrix() = default;
+    ~PatternMatrix();
+
+    PatternMatrix(const PatternMatrix&) = delete;
+    PatternMatrix& operator=(const PatternMatrix&) = delete;
+
+    //maps path if it was built from the same lists, otherwise (re)builds it first
+    //if the file can't be written or mapped the table is kept in memory instead
+    //a table over maxBytes is neither built nor mapped, false is returned and isOpen() stays false
+    bool openOrBuild(const std::string& path, const std::vector<std::string>& guesses, const std::vector<std::string>& answers, size_t maxBytes = PATTERN_MATRIX_DEFAULT_MAX_BYTES);
+
+    //whether a guesses x answers table, one byte per code, stays within maxBytes
+    static bool fits(size_t guessCount, size_t answerCount, size_t maxBytes) { return answerCount == 0 || guessCount <= maxBytes / answerCount; }
+    bool isOpen() const { return this->codes != nullptr; }
+
+    size_t getGuessCount() const { return this->guessCount; }
+    size_t getAnswerCount() const { return this->answerCount; }
+
+    const unsigned char* row(size_t guessIdx) const { return &(this->codes[guessIdx * this->answerCount]); }
+    unsigned char code(size_t guessIdx, size_t answerIdx) const { return this->codes[guessIdx * this->answerCount + answerIdx]; }
+
+    //histogram must hold FEEDBACK_CODE_COUNT ints, it is overwritten
+    //answerIdxs == nullptr means every answer
+    void buildHistogram(size_t guessIdx, const int* answerIdxs, size_t answers, int* histogram) const;
+    //adds answers [begin, end) to histogram without clearing it, returns how much sum(bucket^2) grew
+    int64_t accumulateHistogram(size_t guessIdx, const int* answerIdxs, size_t begin, size_t end, int* histogram) const;
+    float countAvgRemaining(size_t guessIdx, const int* answerIdxs, size_t answers) const;
+
+private:
+    bool mapFile(const std::string& path, uint64_t expectedHash);
+    void unmap();
+
+    const unsigned char* codes = nullptr;
+    size_t guessCount = 0;
+    size_t answerCount = 0;
+
+    std::vector<unsigned char> ownedCodes; //fallback when the file can't be used
+
+    const void* mappedView = nullptr;
+    size_t mappedSize = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+};
@@ -0,0 +1,134 @@
+#include "sampledscoring.hpp"
+#include "packedwords.hpp"
+#include "words.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+void sampledEstimate(const int* histogram, size_t sampled, size_t population, ScoringMetric metric, float z, float& estimate, float& errorBar) {
+    errorBar = 0.0f;
+    if (sampled >= population || sampled < 2) {
+        estimate = metricValue(histogramMetrics(histogram, sampled), metric);
+        return;
+    }
+
+    const double m = (double)sampled;
+    const double n = (double)population;
+    //sampling without replacement, the variance shrinks to nothing as the sample covers the population
+    const double finiteCorrection = (n - m) / (n - 1.0);
+
+    if (metric == ScoringMetric::ExpectedSize) {
+        //sum(h^2) / n = 1 + (n - 1) * P(two different answers share a code), P estimated from the sampled pairs
+        double pairs = 0.0;
+        for (int i = 0; i < FEEDBACK_CODE_COUNT; i++) {
+            pairs += (double)histogram[i] * (histogram[i] - 1);
+        }
+        double shared = pairs / (m * (m - 1.0));
+        estimate = (float)(1.0 + (n - 1.0) * shared);
+
+        //the chance is the mean over the sampled answers of the share of the other sampled answers in their bucket,
+        //a second order U-statistic, so its variance is about 4 times that of the per answer shares over m
+        double spread = 0.0;
+        for (int i = 0; i < FEEDBACK_CODE_COUNT; i++) {
+            if (histogram[i] == 0) continue;
+            double share = (histogram[i] - 1) / (m - 1.0);
+            spread += histogram[i] * (share - shared) * (share - shared);
+        }
+        double variance = 4.0 * spread / (m - 1.0) / m * finiteCorrection;
+        errorBar = (float)(z * (n - 1.0) * std::sqrt(variance));
+    }
+    else {
+        double entropy = 0.0;
+        double squares = 0.0;
+        int buckets = 0;
+        for (int i = 0; i < FEEDBACK_CODE_COUNT; i++) {
+            if (histogram[i] == 0) continue;
+            double p = histogram[i] / m;
+            double bits = std::log2(p);
+            entropy -= p * bits;
+            squares += p * bits * bits;
+            buckets++;
+        }
+        //plug-in entropy comes out low by about (buckets - 1) / 2m nats
+        estimate = (float)(entropy + (buckets - 1) / (2.0 * m * std::log(2.0)) * finiteCorrection);
+
+        double variance = std::max(0.0, squares - entropy * entropy) / m * finiteCorrection;
+        errorBar = (float)(z * std::sqrt(variance));
+    }
+}
+
+std::vector<int> stratifiedSampleOrder(const std::vector<std::string>& words, uint64_t seed) {
+    std::mt19937_64 rng{ seed };
+    std::uniform_real_distribution<double> offset{ 0.0, 1.0 };
+
+    std::vector<std::vector<int>> strata(32);
+    for (int i = 0; i < words.size(); i++) {
+        strata[words[i][0] & 31].push_back(i);
+    }
+
+    //rank r of a stratum of s words lands at (r + u) / s, so the strata interleave in proportion
+    std::vector<std::pair<double, int>> keyed;
+    keyed.reserve(words.size());
+    for (std::vector<int>& stratum : strata) {
+        if (stratum.empty()) continue;
+        std::shuffle(stratum.begin(), stratum.end(), rng);
+
+        double u = offset(rng);
+        for (size_t r = 0; r < stratum.size(); r++) {
+            keyed.push_back({ (r + u) / stratum.size(), stratum[r] });
+        }
+    }
+    std::sort(keyed.begin(), keyed.end());
+
+    std::vector<int> order(keyed.size());
+    for (size_t i = 0; i < keyed.size(); i++) order[i] = keyed[i].second;
+    return order;
+}
+
+void AnswerSample::AlignedFree::operator()(unsigned char* mem) const {
+    _aligned_free(mem);
+}
+
+AnswerSample::AnswerSample(const std::vector<std::string>& candidates, uint64_t seed, SimdLevel simdLevel)
+    : simdLevel{ simdLevel }, packwidth{ simdLevelPackWidth(simdLevel) }, words{ candidates.size() }
+{
+    std::vector<std::string> ordered;
+    ordered.reserve(candidates.size());
+    for (int idx : stratifiedSampleOrder(candidates, seed)) {
+        ordered.push_back(candidates[idx]);
+    }
+
+    if (simdLevel >= SimdLevel::AVX2) {
+        size_t bytes = hyperpackedListBytes<5>(this->words, this->packwidth);
+        this->hyperpacked.reset((unsigned char*)_aligned_malloc(bytes == 0 ? 64 : bytes, 64));
+        hyperpackWordList<5>(ordered, this->packwidth, this->hyperpacked.get());
+    }
+    else {
+        this->patterns.reset(new PatternWordlist{ ordered });
+    }
+}
+
+size_t AnswerSample::prefixSize(size_t sampled) const {
+    if (sampled >= this->words) return this->words;
+
+    //batches of 64 suit both pack widths, the padding of a partial batch would count real words
+    size_t prefix = sampled - sampled % 64;
+    return (prefix == 0) ? std::min<size_t>(64, this->words) : prefix;
+}
+
+void AnswerSample::histogram(const char* guess, size_t sampled, int* histogram) const {
+    switch (this->simdLevel) {
+    case SimdLevel::AVX512:
+        hyperpacked_feedbackHistogram_AVX512(guess, this->hyperpacked.get(), sampled, histogram);
+        break;
+    case SimdLevel::AVX2:
+        hyperpacked_feedbackHistogram(guess, this->hyperpacked.get(), sampled, histogram);
+        break;
+    default:
+        std::memset(histogram, 0, sizeof(int) * FEEDBACK_CODE_COUNT);
+        this->patterns->accumulateHistogram(guess, 0, sampled, histogram);
+        break;
+    }
+}
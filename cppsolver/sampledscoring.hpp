@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+
+#include "cpufeatures.hpp"
+#include "feedbackpattern.hpp"
+#include "scoringmetrics.hpp"
+
+inline bool sampledMetric(ScoringMetric metric) { return metric == ScoringMetric::ExpectedSize || metric == ScoringMetric::Entropy; }
+
+struct SamplingConfig {
+    // answers in the first round, every later round doubles it
+    size_t initialSample = 1024;
+    // stop refining here even if intervals still overlap, 0 to go on until the estimates are exact
+    size_t maxSample = 0;
+    // confidence interval half width in standard errors, 1.96 for 95%
+    float z = 1.96f;
+    uint64_t seed = 1;
+};
+
+struct SampledGuess {
+    int guessIdx;    // index into the search words
+    float estimate;  // the metric's value estimated from the sample, exact once sampled covers every candidate
+    float errorBar;  // half width of the confidence interval, 0 when exact
+    size_t sampled;  // candidates the estimate is over
+};
+
+// estimate of a metric over population answers from the histogram of the first sampled answers of a sample order
+// ExpectedSize: 1 + (population - 1) * the sampled chance that two different answers share a code, unbiased
+// Entropy: plug-in entropy plus the Miller-Madow bias correction, scaled down as the sample covers the population
+// error bars from the usual large sample variances with the finite population correction, so both reach 0 at
+// sampled == population, where the estimates are histogramMetrics' values
+// only those two metrics are estimated, see sampledMetric
+void sampledEstimate(const int* histogram, size_t sampled, size_t population, ScoringMetric metric, float z, float& estimate, float& errorBar);
+
+// the candidates reordered so that every prefix is a stratified random sample of them, strata by first letter:
+// each stratum is shuffled and its words spread evenly over the order, so any prefix holds each first letter
+// in proportion to within one word
+std::vector<int> stratifiedSampleOrder(const std::vector<std::string>& words, uint64_t seed);
+
+// candidates in sample order, packed once for the histogram kernels
+// prefixes of it are scored, see prefixSize
+class AnswerSample {
+public:
+    AnswerSample(const std::vector<std::string>& candidates, uint64_t seed, SimdLevel simdLevel);
+
+    size_t size() const { return this->words; }
+    // the largest prefix at most sampled long the kernels can read on its own, a whole number of batches or everything
+    size_t prefixSize(size_t sampled) const;
+
+    // histogram of guess over the first sampled answers, sampled from prefixSize, FEEDBACK_CODE_COUNT ints overwritten
+    void histogram(const char* guess, size_t sampled, int* histogram) const;
+
+private:
+    struct AlignedFree {
+        void operator()(unsigned char* mem) const;
+    };
+
+    SimdLevel simdLevel;
+    int packwidth;
+    size_t words;
+    std::unique_ptr<unsigned char[], AlignedFree> hyperpacked; //AVX2/AVX-512 only
+    std::unique_ptr<PatternWordlist> patterns;                 //every other level
+};
@@ -0,0 +1,101 @@
+#include "scoringmetrics.hpp"
+#include "feedbackpattern.hpp"
+#include "words.h"
+
+#include <cmath>
+
+//b * log2(b) for the bucket sizes that come up almost every time, so entropy costs no logs per guess
+static constexpr int xLog2xTableSize = 4096;
+
+struct XLog2xTable {
+    float values[xLog2xTableSize];
+
+    XLog2xTable() {
+        values[0] = 0.0f;
+        for (int b = 1; b < xLog2xTableSize; b++) {
+            values[b] = (float)(b * std::log2((double)b));
+        }
+    }
+};
+
+static const XLog2xTable& xLog2xTable() {
+    static const XLog2xTable table;
+    return table;
+}
+
+HistogramMetrics histogramMetrics(const int* histogram, size_t words) {
+    HistogramMetrics metrics;
+    if (words == 0) return metrics;
+
+    const float* xLog2x = xLog2xTable().values;
+
+    int64_t sumSquares = 0;
+    double sumXLog2x = 0.0;
+    int largest = 0;
+    int buckets = 0;
+    for (int i = 0; i < FEEDBACK_CODE_COUNT; i++) {
+        int b = histogram[i];
+        if (b == 0) continue;
+
+        sumSquares += (int64_t)b * b;
+        sumXLog2x += (b < xLog2xTableSize) ? xLog2x[b] : b * std::log2((double)b);
+        if (b > largest) largest = b;
+        buckets++;
+    }
+
+    double n = (double)words;
+    metrics.sumSquares = sumSquares;
+    metrics.expectedSize = (float)sumSquares / (float)words; //same rounding as histogramAvgRemaining
+    //H = -sum(p log2 p) = log2(n) - sum(b log2 b) / n
+    metrics.entropy = (float)(std::log2(n) - sumXLog2x / n);
+    metrics.worstCase = largest;
+    metrics.solveNow = (float)(histogram[SOLVED_FEEDBACK_CODE] / n);
+    //each bucket is solved next turn with chance 1 / b, weighted by b / n
+    metrics.solveNext = (float)(buckets / n);
+    return metrics;
+}
+
+float metricValue(const HistogramMetrics& metrics, ScoringMetric metric) {
+    switch (metric) {
+    case ScoringMetric::Entropy: return metrics.entropy;
+    case ScoringMetric::WorstCase: return (float)metrics.worstCase;
+    case ScoringMetric::SolveNow: return metrics.solveNow;
+    case ScoringMetric::SolveNext: return metrics.solveNext;
+    default: return metrics.expectedSize;
+    }
+}
+
+float metricRankKey(const HistogramMetrics& metrics, ScoringMetric metric, size_t words) {
+    //expectedSize <= n, so this stays under 1 and only orders guesses the main metric ties
+    float tieBreak = metrics.expectedSize / (float)(words + 1);
+
+    switch (metric) {
+    case ScoringMetric::Entropy: return -metrics.entropy;
+    case ScoringMetric::WorstCase: return (float)metrics.worstCase + tieBreak;
+    //both are counts over n, compare the counts so the tie break fits between them
+    case ScoringMetric::SolveNow: return -std::round(metrics.solveNow * words) + tieBreak;
+    case ScoringMetric::SolveNext: return -std::round(metrics.solveNext * words) + tieBreak;
+    default: return metrics.expectedSize;
+    }
+}
+
+const char* scoringMetricName(ScoringMetric metric) {
+    switch (metric) {
+    case ScoringMetric::Entropy: return "entropy";
+    case ScoringMetric::WorstCase: return "worst";
+    case ScoringMetric::SolveNow: return "solve";
+    case ScoringMetric::SolveNext: return "solve2";
+    default: return "expected";
+    }
+}
+
+bool parseScoringMetric(const std::string& name, ScoringMetric& metric) {
+    const ScoringMetric metrics[] = { ScoringMetric::ExpectedSize, ScoringMetric::Entropy, ScoringMetric::WorstCase, ScoringMetric::SolveNow, ScoringMetric::SolveNext };
+    for (ScoringMetric m : metrics) {
+        if (name == scoringMetricName(m)) {
+            metric = m;
+            return true;
+        }
+    }
+    return false;
+}
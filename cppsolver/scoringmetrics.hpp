@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// ways to rank a guess, all read from the same feedback code histogram
+enum class ScoringMetric {
+    ExpectedSize, // average candidates left, sum(bucket^2) / n (the original ranking)
+    Entropy,      // information gained in bits
+    WorstCase,    // largest bucket, for adversarial (Absurdle style) games
+    SolveNow,     // chance the guess itself is the answer
+    SolveNext     // chance of being solved by this guess or the next, guessing a candidate each time
+};
+
+struct HistogramMetrics {
+    int64_t sumSquares = 0; // sum(bucket^2), expectedSize * n without rounding
+    float expectedSize = 0.0f;
+    float entropy = 0.0f;
+    int worstCase = 0;
+    float solveNow = 0.0f;
+    float solveNext = 0.0f;
+};
+
+// one walk over the FEEDBACK_CODE_COUNT buckets, every metric at once
+HistogramMetrics histogramMetrics(const int* histogram, size_t words);
+
+// the metric itself, as reported to users
+float metricValue(const HistogramMetrics& metrics, ScoringMetric metric);
+// lower is better for every metric, ties on the coarse metrics are broken by expected size
+float metricRankKey(const HistogramMetrics& metrics, ScoringMetric metric, size_t words);
+
+// true if the metric can only be read from a histogram, the filter kernels only give the expected size
+inline bool metricNeedsHistogram(ScoringMetric metric) { return metric != ScoringMetric::ExpectedSize; }
+
+const char* scoringMetricName(ScoringMetric metric);
+// accepts the names returned by scoringMetricName, false if unknown
+bool parseScoringMetric(const std::string& name, ScoringMetric& metric);
@@ -0,0 +1,242 @@
+#include "selftest.hpp"
+#include "words.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "feedbackpattern.hpp"
+#include "wordfilter.hpp"
+#include "gamesession.hpp"
+#include "server.hpp"
+
+struct SelfTestReport {
+    int checks = 0;
+    int failed = 0;
+
+    void expect(bool ok, const std::string& what) {
+        this->checks++;
+        if (ok) return;
+        this->failed++;
+        std::cout << "FAIL: " << what << "\n";
+    }
+};
+
+static std::string feedbackDigits(unsigned char code) {
+    unsigned char states[5];
+    feedbackCodeStates(code, states);
+    std::string digits;
+    for (int i = 0; i < 5; i++) digits += (char)('0' + states[i]);
+    return digits;
+}
+
+//guesses that repeat a letter, where Wordle's rule differs from present anywhere
+static const char* const repeatedLetterGuesses[] = { "speed", "geese", "eerie", "llama", "label", "asses", "sissy", "mamma" };
+
+//answer, guess, digits as Wordle shows them
+static void testRepeatedLetterFeedback(SelfTestReport& report) {
+    const char* const cases[][3] = {
+        { "abide", "speed", "00101" }, //one e in the answer, only the first e is misplaced
+        { "those", "geese", "00022" }, //the answer's only e is taken by the green
+        { "eerie", "geese", "02102" },
+        { "eerie", "eyrie", "20222" },
+        { "llama", "label", "21001" },
+        { "lapel", "llama", "21100" },
+        { "sassy", "asses", "11201" },
+        { "crepe", "eerie", "10102" },
+    };
+
+    for (const auto& c : cases) {
+        unsigned char expected;
+        parseFeedbackPattern(c[2], expected);
+        unsigned char code = computeFeedbackCode(c[0], c[1]);
+        report.expect(code == expected, std::string("feedback ") + c[1] + " against " + c[0] + " is " + feedbackDigits(code) + ", expected " + c[2]);
+    }
+}
+
+//the pattern list and the simd kernels against computeFeedbackCode over every answer
+static void testFeedbackKernels(SelfTestReport& report, const CpuFeatures& features) {
+    const std::vector<std::string>& answers = validWords.strings();
+    PatternWordlist patternList{ answers };
+    std::vector<unsigned char> codes(answers.size() + 64);
+    int histogram[FEEDBACK_CODE_COUNT];
+    int kernelHistogram[FEEDBACK_CODE_COUNT];
+
+    std::vector<std::string> guesses(std::begin(repeatedLetterGuesses), std::end(repeatedLetterGuesses));
+    guesses.push_back("roate");
+
+    for (const std::string& guess : guesses) {
+        patternList.buildHistogram(guess.c_str(), histogram);
+
+        size_t mismatches = 0;
+        for (size_t i = 0; i < answers.size(); i++) {
+            if (patternList.feedbackCode(i, guess.c_str()) != computeFeedbackCode(answers[i].c_str(), guess.c_str())) mismatches++;
+        }
+        report.expect(mismatches == 0, "pattern list codes for " + guess + " differ from computeFeedbackCode on " + std::to_string(mismatches) + " answers");
+
+        for (int packwidth : { 32, 64 }) {
+            if (packwidth == 32 ? !features.avx2 : !features.avx512bw) continue;
+            std::string kernel = (packwidth == 32) ? "avx2" : "avx512";
+
+            if (packwidth == 32) hyperpacked_feedbackCodes(guess.c_str(), validWords.hyperpacked(32), answers.size(), codes.data());
+            else hyperpacked_feedbackCodes_AVX512(guess.c_str(), validWords.hyperpacked(64), answers.size(), codes.data());
+            mismatches = 0;
+            for (size_t i = 0; i < answers.size(); i++) {
+                if (codes[i] != computeFeedbackCode(answers[i].c_str(), guess.c_str())) mismatches++;
+            }
+            report.expect(mismatches == 0, kernel + " codes for " + guess + " differ from computeFeedbackCode on " + std::to_string(mismatches) + " answers");
+
+            if (packwidth == 32) hyperpacked_feedbackHistogram(guess.c_str(), validWords.hyperpacked(32), answers.size(), kernelHistogram);
+            else hyperpacked_feedbackHistogram_AVX512(guess.c_str(), validWords.hyperpacked(64), answers.size(), kernelHistogram);
+            report.expect(std::equal(histogram, histogram + FEEDBACK_CODE_COUNT, kernelHistogram), kernel + " histogram for " + guess + " differs from the pattern list");
+        }
+    }
+}
+
+//count limits the feedback on a repeated guess letter gives
+static void testRepeatedLetterFilters(SelfTestReport& report) {
+    const int e = 'e' - 'a';
+
+    //speed against abide is 00101, the wrong second e caps the e's at one
+    WordFilter oneE{ "abide", "speed" };
+    report.expect(oneE.minCount[e] == 1 && oneE.maxCount[e] == 1, "speed against abide allows exactly one e");
+    report.expect(oneE.wrong.contains('s') && oneE.wrong.contains('p') && !oneE.wrong.contains('e'), "speed against abide rules out s and p but not e");
+
+    //speed against eerie is 00110, both e's found
+    WordFilter twoE{ "eerie", "speed" };
+    report.expect(twoE.minCount[e] == 2 && twoE.maxCount[e] == 5, "speed against eerie asks for at least two e's");
+
+    const std::vector<std::string> words = { "abide", "eerie", "ended", "dealt", "elite", "aside" };
+    report.expect(oneE.filterWords(words) == std::vector<std::string>{ "abide", "dealt" }, "speed against abide keeps the words with one e, away from the third and fourth letter");
+    report.expect(twoE.filterWords(words) == std::vector<std::string>{ "eerie", "elite" }, "speed against eerie keeps the words with two or more e's and no d");
+}
+
+//every filter path against the answers giving the same feedback, for guesses that repeat a letter
+static void testFilterKernels(SelfTestReport& report, const CpuFeatures& features) {
+    const std::vector<std::string>& answers = validWords.strings();
+    PatternWordlist patternList{ answers };
+    int histogram[FEEDBACK_CODE_COUNT];
+
+    //a spread of solutions, a block's worth for the blocked kernels
+    std::vector<char> solutions;
+    for (size_t i = 0; i < answers.size() && solutions.size() < WordFilter::filterBlockSize * 5; i += answers.size() / WordFilter::filterBlockSize + 1) {
+        solutions.insert(solutions.end(), answers[i].begin(), answers[i].end());
+    }
+    int solutionCount = (int)(solutions.size() / 5);
+    std::vector<int> blockCounts(solutionCount);
+
+    for (const char* guess : repeatedLetterGuesses) {
+        patternList.buildHistogram(guess, histogram);
+
+        size_t mismatches[5] = {};
+        for (int s = 0; s < solutionCount; s++) {
+            const char* solution = &solutions[s * 5];
+            WordFilter filter{ solution, guess };
+            int expected = histogram[computeFeedbackCode(solution, guess)];
+
+            if (filter.filterWordsCount(answers) != expected) mismatches[0]++;
+            if (features.sse42 && filter.optimized_filterWordsCount(validWords.flat(), answers.size(), nullptr) != expected) mismatches[1]++;
+            if (features.avx2 && filter.hyperpacked_optimized_filterWordsCount(validWords.hyperpacked(32), answers.size()) != expected) mismatches[2]++;
+            if (features.avx512bw && filter.hyperpacked_optimized_filterWordsCount_AVX512(validWords.hyperpacked(64), answers.size()) != expected) mismatches[3]++;
+        }
+
+        if (features.avx2) {
+            WordFilter::hyperpacked_blockFilterWordsCount(guess, solutions.data(), solutionCount, validWords.hyperpacked(32), answers.size(), blockCounts.data());
+            for (int s = 0; s < solutionCount; s++) {
+                if (blockCounts[s] != histogram[computeFeedbackCode(&solutions[s * 5], guess)]) mismatches[4]++;
+            }
+        }
+        if (features.avx512bw) {
+            WordFilter::hyperpacked_blockFilterWordsCount_AVX512(guess, solutions.data(), solutionCount, validWords.hyperpacked(64), answers.size(), blockCounts.data());
+            for (int s = 0; s < solutionCount; s++) {
+                if (blockCounts[s] != histogram[computeFeedbackCode(&solutions[s * 5], guess)]) mismatches[4]++;
+            }
+        }
+
+        const char* const paths[5] = { "scalar", "sse42", "avx2", "avx512", "blocked" };
+        for (int p = 0; p < 5; p++) {
+            report.expect(mismatches[p] == 0, std::string(paths[p]) + " filter counts for " + guess + " differ from the feedback buckets for " + std::to_string(mismatches[p]) + " solutions");
+        }
+    }
+}
+
+//a game against abide replayed through the session with the feedback Wordle shows, at every level the cpu runs
+static void testSessionReplay(SelfTestReport& report, const CpuFeatures& features) {
+    std::vector<std::string> dictionary = validWords.strings();
+    if (std::find(dictionary.begin(), dictionary.end(), "abide") == dictionary.end()) dictionary.push_back("abide");
+    const char* const guesses[] = { "speed", "eerie", "llama", "abbey" };
+
+    for (SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE42, SimdLevel::AVX2, SimdLevel::AVX512 }) {
+        if (!simdLevelSupported(features, level)) continue;
+
+        GameSession session{ dictionary, level };
+        for (const char* guess : guesses) {
+            unsigned char code = computeFeedbackCode("abide", guess);
+            session.applyFeedback(guess, code);
+
+            bool kept = false;
+            size_t inconsistent = 0;
+            for (size_t i = 0; i < session.size(); i++) {
+                kept |= std::memcmp(session.candidateWord(i), "abide", 5) == 0;
+                if (computeFeedbackCode(session.candidateWord(i), guess) != code) inconsistent++;
+            }
+            std::string turn = std::string(simdLevelName(level)) + " session after " + guess + ":" + feedbackDigits(code);
+            report.expect(kept, turn + " dropped abide");
+            report.expect(inconsistent == 0, turn + " kept " + std::to_string(inconsistent) + " words giving other feedback");
+        }
+    }
+}
+
+//server replies against the command line's path for the same turns: a session narrowing the answers, then rankGuesses
+static void testServerMatchesCli(SelfTestReport& report, const SolverConfig& config) {
+    SolverConfig solverConfig = config;
+    solverConfig.pattern_matrix_mode = false;
+    Solver solver{ solverConfig, allWords.strings(), validWords.strings(), &validWords };
+
+    //guesses played against an answer, the feedback is what that answer gives
+    const std::vector<std::pair<const char*, std::vector<const char*>>> games = {
+        { "abide", { "speed" } },
+        { "abide", { "speed", "eerie" } },
+        { "those", { "geese", "llama" } },
+        { "eerie", { "roate", "geese" } },
+        { "sassy", { "asses" } },
+    };
+
+    for (const auto& game : games) {
+        std::string line = "k=10";
+        GameSession session{ solver.getAnswerWords(), config.simdLevel };
+        for (const char* guess : game.second) {
+            unsigned char code = computeFeedbackCode(game.first, guess);
+            line += std::string(" turn=") + guess + ":" + feedbackDigits(code);
+            session.applyFeedback(guess, code);
+        }
+        std::vector<std::string> cliCandidates;
+        for (size_t i = 0; i < session.size(); i++) cliCandidates.emplace_back(session.candidateWord(i), 5);
+
+        ServerRequest request = prepareServerRequest(solver, line);
+        report.expect(request.error.empty() && request.candidates == cliCandidates, "server request \"" + line + "\" leaves " + std::to_string(request.candidates.size()) + " candidates, the session " + std::to_string(cliCandidates.size()));
+        if (request.candidates.empty() || request.candidates != cliCandidates) continue;
+
+        std::string serverReply = formatServerReply(solver, request, solver.rankGuesses(request.candidates, request.topK, request.metric));
+        ServerRequest cliRequest = request;
+        cliRequest.candidates = cliCandidates;
+        std::string cliReply = formatServerReply(solver, cliRequest, solver.rankGuesses(cliCandidates, 10));
+        report.expect(serverReply == cliReply, "server reply \"" + serverReply + "\" differs from the command line's \"" + cliReply + "\"");
+    }
+}
+
+int runSelfTests(const CpuFeatures& features, const SolverConfig& config) {
+    SelfTestReport report;
+
+    testRepeatedLetterFeedback(report);
+    testFeedbackKernels(report, features);
+    testRepeatedLetterFilters(report);
+    testFilterKernels(report, features);
+    testSessionReplay(report, features);
+    testServerMatchesCli(report, config);
+
+    std::cout << "self test: " << report.checks << " checks, " << report.failed << " failed\n";
+    return report.failed;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "cpufeatures.hpp"
+#include "solver.hpp"
+
+//checks run by --self-test against the built in word lists
+//the kernels are only checked where the cpu runs them, every failure is printed
+//config is what a solver for the server checks gets, less the pattern matrix file
+//returns the number of failed checks
+int runSelfTests(const CpuFeatures& features, const SolverConfig& config);
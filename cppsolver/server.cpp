@@ -0,0 +1,410 @@
+#include "server.hpp"
+#include "wordfilter.hpp"
+#include "feedbackpattern.hpp"
+#include "words.h"
+
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <filesystem>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <afunix.h>
+#pragma comment(lib, "Ws2_32.lib")
+typedef SOCKET socket_t;
+#define closeSocket closesocket
+#define SEND_FLAGS 0
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+typedef int socket_t;
+#define INVALID_SOCKET (-1)
+#define closeSocket close
+#define SEND_FLAGS MSG_NOSIGNAL
+#endif
+
+bool readLetters(const std::string& text, std::string& letters) {
+    letters.clear();
+    for (char c : text) {
+        if (c >= 'A' && c <= 'Z') c = c - 'A' + 'a';
+        if (c < 'a' || c > 'z') return false;
+        letters.push_back(c);
+    }
+    return true;
+}
+
+ServerRequest prepareServerRequest(const Solver& solver, const std::string& line) {
+    ServerRequest request;
+
+    std::array<char, 5> correct = { ' ', ' ', ' ', ' ', ' ' };
+    std::array<std::vector<char>, 5> misplaced = {{
+        {}, {}, {}, {}, {}
+    }};
+    std::string wrong = "";
+    std::vector<std::pair<std::string, unsigned char>> turns;
+
+    std::istringstream tokens(line);
+    std::string token;
+    std::string letters;
+    while (tokens >> token) {
+        size_t split = token.find('=');
+        if (split == std::string::npos) {
+            request.error = "expected key=value, got " + token;
+            return request;
+        }
+        std::string key = token.substr(0, split);
+        std::string value = token.substr(split + 1);
+
+        if (key == "id") {
+            request.id = value;
+        }
+        else if (key == "k") {
+            try {
+                request.topK = std::stoi(value);
+            }
+            catch (const std::exception&) {
+                request.topK = 0;
+            }
+            if (request.topK <= 0) {
+                request.error = "k must be a positive number";
+                return request;
+            }
+        }
+        else if (key == "metric") {
+            if (!parseScoringMetric(value, request.metric)) {
+                request.error = "metric must be expected, entropy, worst, solve or solve2";
+                return request;
+            }
+        }
+        else if (key == "correct") {
+            if (value.size() != 5) {
+                request.error = "correct takes 5 letters, _ for unknown";
+                return request;
+            }
+            for (int i = 0; i < 5; i++) {
+                if (value[i] == '_') continue;
+                if (!readLetters(value.substr(i, 1), letters)) {
+                    request.error = "correct takes 5 letters, _ for unknown";
+                    return request;
+                }
+                correct[i] = letters[0];
+            }
+        }
+        else if (key == "misplaced") {
+            //one group per position, missing trailing groups are empty
+            int position = 0;
+            size_t start = 0;
+            while (true) {
+                size_t end = value.find('/', start);
+                std::string group = value.substr(start, (end == std::string::npos) ? std::string::npos : end - start);
+                if (position >= 5 || !readLetters(group, letters)) {
+                    request.error = "misplaced takes up to 5 slash separated letter groups";
+                    return request;
+                }
+                misplaced[position].insert(misplaced[position].end(), letters.begin(), letters.end());
+                position++;
+
+                if (end == std::string::npos) break;
+                start = end + 1;
+            }
+        }
+        else if (key == "wrong") {
+            if (!readLetters(value, letters)) {
+                request.error = "wrong takes letters only";
+                return request;
+            }
+            wrong += letters;
+        }
+        else if (key == "deadline") {
+            try {
+                request.deadline = std::stod(value);
+            }
+            catch (const std::exception&) {
+                request.deadline = 0.0;
+            }
+            if (!(request.deadline > 0)) {
+                request.error = "deadline must be a positive number of seconds";
+                return request;
+            }
+        }
+        else if (key == "hard") {
+            if (value != "0" && value != "1") {
+                request.error = "hard takes 0 or 1";
+                return request;
+            }
+            request.hardMode = value == "1";
+        }
+        else if (key == "turn") {
+            unsigned char code;
+            if (value.size() != 11 || value[5] != ':' || !readLetters(value.substr(0, 5), letters) || !parseFeedbackPattern(value.substr(6), code)) {
+                request.error = "turns look like turn=roate:00120";
+                return request;
+            }
+            turns.emplace_back(letters, code);
+        }
+        else {
+            request.error = "unknown key " + key;
+            return request;
+        }
+    }
+
+    //each turn's feedback is a filter too, so the answer index narrows by the turns and the filter in one pass
+    WordFilter filter = playedTurnsFilter(WordFilter{ correct, misplaced, wrong }, turns);
+    request.candidates = solver.filterAnswers(filter);
+
+    if (request.hardMode) {
+        request.guessIdxs = solver.legalGuesses(filter);
+    }
+
+    return request;
+}
+
+std::string formatServerReply(const Solver& solver, const ServerRequest& request, const std::vector<ScoredGuess>& guesses, const DeadlineRanking* deadline) {
+    std::ostringstream reply;
+    if (!request.id.empty()) reply << "id=" << request.id << " ";
+
+    if (!request.error.empty()) {
+        reply << "error " << request.error;
+        return reply.str();
+    }
+
+    reply << "ok n=" << request.candidates.size();
+    if (deadline != nullptr) reply << " evaluated=" << deadline->evaluated << "/" << deadline->total;
+    for (int i = 0; i < guesses.size(); i++) {
+        reply << " " << solver.getSearchWords()[guesses[i].guessIdx] << ":" << guesses[i].score;
+    }
+    return reply.str();
+}
+
+//two stage pipeline: a reader thread parses and filters upcoming requests while this thread ranks the current one
+//replies are written in request order
+static void serveLines(Solver& solver, const std::function<bool(std::string&)>& readLine, const std::function<bool(const std::string&, bool)>& writeLine) {
+    const size_t maxQueued = 8;
+
+    std::mutex queueLock;
+    std::condition_variable queueChanged;
+    std::deque<ServerRequest> queued;
+    bool readerDone = false;
+    bool writerDone = false;
+
+    std::thread reader([&]() {
+        std::string line;
+        while (readLine(line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty()) continue;
+            if (line == "quit") break;
+
+            ServerRequest request = prepareServerRequest(solver, line);
+
+            std::unique_lock<std::mutex> lock(queueLock);
+            queueChanged.wait(lock, [&] { return queued.size() < maxQueued || writerDone; });
+            if (writerDone) break;
+            queued.push_back(std::move(request));
+            queueChanged.notify_all();
+        }
+
+        std::unique_lock<std::mutex> lock(queueLock);
+        readerDone = true;
+        queueChanged.notify_all();
+    });
+
+    while (true) {
+        ServerRequest request;
+        bool more;
+        {
+            std::unique_lock<std::mutex> lock(queueLock);
+            queueChanged.wait(lock, [&] { return !queued.empty() || readerDone; });
+            if (queued.empty()) break;
+
+            request = std::move(queued.front());
+            queued.pop_front();
+            more = !queued.empty();
+            queueChanged.notify_all();
+        }
+
+        std::vector<ScoredGuess> guesses;
+        DeadlineRanking deadlineRanking;
+        const bool deadline = request.error.empty() && request.deadline > 0;
+        if (request.error.empty() && !request.candidates.empty()) {
+            const std::vector<int>* guessIdxs = request.hardMode ? &request.guessIdxs : nullptr;
+            if (deadline) {
+                deadlineRanking = solver.rankGuessesDeadline(request.candidates, request.topK, request.deadline, request.metric, guessIdxs);
+                guesses = deadlineRanking.guesses;
+            }
+            else {
+                guesses = solver.rankGuesses(request.candidates, request.topK, request.metric, guessIdxs);
+            }
+        }
+
+        //only flush once the queue runs dry, so a burst of requests goes out in one write
+        if (!writeLine(formatServerReply(solver, request, guesses, deadline ? &deadlineRanking : nullptr), !more)) {
+            std::unique_lock<std::mutex> lock(queueLock);
+            writerDone = true;
+            queueChanged.notify_all();
+            break;
+        }
+    }
+
+    reader.join();
+}
+
+int runStdioServer(Solver& solver) {
+    //cin is tied to cout by default, which would flush cout from the reader thread
+    std::cin.tie(nullptr);
+
+    serveLines(solver,
+        [](std::string& line) {
+            return (bool)std::getline(std::cin, line);
+        },
+        [](const std::string& reply, bool flush) {
+            std::cout << reply << '\n';
+            if (flush) std::cout.flush();
+            return (bool)std::cout;
+        }
+    );
+    return 0;
+}
+
+static void serveConnection(Solver& solver, socket_t client) {
+    std::string pending;
+    std::string outgoing;
+
+    serveLines(solver,
+        [&](std::string& line) {
+            while (true) {
+                size_t newline = pending.find('\n');
+                if (newline != std::string::npos) {
+                    line = pending.substr(0, newline);
+                    pending.erase(0, newline + 1);
+                    return true;
+                }
+
+                char buffer[4096];
+                int received = (int)recv(client, buffer, sizeof(buffer), 0);
+                if (received <= 0) {
+                    //last line without a newline
+                    if (pending.empty()) return false;
+                    line.swap(pending);
+                    pending.clear();
+                    return true;
+                }
+                pending.append(buffer, received);
+            }
+        },
+        [&](const std::string& reply, bool flush) {
+            outgoing += reply;
+            outgoing += '\n';
+            if (!flush) return true;
+
+            size_t sent = 0;
+            while (sent < outgoing.size()) {
+                int result = (int)send(client, outgoing.data() + sent, (int)(outgoing.size() - sent), SEND_FLAGS);
+                if (result <= 0) {
+                    //wake the reader if it is blocked in recv
+#ifdef _WIN32
+                    shutdown(client, SD_BOTH);
+#else
+                    shutdown(client, SHUT_RDWR);
+#endif
+                    return false;
+                }
+                sent += result;
+            }
+            outgoing.clear();
+            return true;
+        }
+    );
+
+    closeSocket(client);
+}
+
+int runUnixSocketServer(Solver& solver, const std::string& path) {
+#ifdef _WIN32
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        std::cout << "could not start winsock" << std::endl;
+        return 1;
+    }
+#endif
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        std::cout << "socket path is too long: " << path << std::endl;
+        return 1;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    socket_t listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener == INVALID_SOCKET) {
+        std::cout << "could not create socket" << std::endl;
+        return 1;
+    }
+
+    //a socket file left behind by a previous run would make bind fail
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+
+    if (bind(listener, (const sockaddr*)&address, sizeof(address)) != 0 || listen(listener, SOMAXCONN) != 0) {
+        std::cout << "could not listen on " << path << std::endl;
+        closeSocket(listener);
+        return 1;
+    }
+    std::cout << "listening on " << path << std::endl;
+
+    struct Connection {
+        std::thread thread;
+        std::shared_ptr<std::atomic<bool>> finished;
+    };
+    std::vector<Connection> connections;
+
+    while (true) {
+        socket_t client = accept(listener, nullptr, nullptr);
+        if (client == INVALID_SOCKET) {
+#ifndef _WIN32
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+#endif
+            break;
+        }
+
+        //join connections that have closed so their threads don't pile up
+        for (int i = 0; i < connections.size(); ) {
+            if (connections[i].finished->load()) {
+                connections[i].thread.join();
+                connections[i] = std::move(connections.back());
+                connections.pop_back();
+            }
+            else {
+                i++;
+            }
+        }
+
+        auto finished = std::make_shared<std::atomic<bool>>(false);
+        connections.push_back({ std::thread([&solver, client, finished]() {
+            serveConnection(solver, client);
+            finished->store(true);
+        }), finished });
+    }
+
+    for (int i = 0; i < connections.size(); i++) {
+        connections[i].thread.join();
+    }
+    closeSocket(listener);
+    std::filesystem::remove(path, ec);
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return 0;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+#include <string>
+
+#include "solver.hpp"
+
+// long running query mode, one warm Solver answers every request
+//
+// requests are one line each, space separated key=value tokens, all optional:
+//   id=<text>                 echoed back so replies can be matched up
+//   correct=__a__             5 letters, _ for unknown
+//   misplaced=r/e///t         5 slash separated letter groups, one per position
+//   wrong=xyz                 letters not in the answer
+//   turn=roate:00120          a played turn (0/1/2 per letter), repeatable, applied before the filter
+//   k=10                      number of guesses to return
+//   metric=expected           ranking: expected, entropy, worst, solve or solve2 (see ScoringMetric)
+//   deadline=0.005            seconds to rank in, guesses are scored most promising first until it passes
+//   hard=1                    hard mode, only guesses consistent with the turns and filter are ranked
+// replies are one line each, in request order:
+//   id=<text> ok n=<candidates left> <guess>:<score> ...
+//   id=<text> ok n=<candidates left> evaluated=<guesses scored>/<guesses> <guess>:<score> ...   with a deadline
+//   id=<text> error <reason>
+// "quit" on its own line ends the stream
+
+struct ServerRequest {
+    std::string id;
+    int topK = 10;
+    ScoringMetric metric = ScoringMetric::ExpectedSize;
+    std::vector<std::string> candidates;
+    double deadline = 0.0; // seconds, 0 ranks every guess
+    bool hardMode = false;
+    std::vector<int> guessIdxs; // legal guesses in hard mode
+    std::string error; // set if the line couldn't be parsed, nothing else is valid then
+};
+
+// letters of a request or --turn guess, upper case is lowered, false on anything outside a-z
+bool readLetters(const std::string& text, std::string& letters);
+
+// parses a request line and narrows the solver's answer words with it
+ServerRequest prepareServerRequest(const Solver& solver, const std::string& line);
+// deadline, if given, is how the deadline ranking went
+std::string formatServerReply(const Solver& solver, const ServerRequest& request, const std::vector<ScoredGuess>& guesses, const DeadlineRanking* deadline = nullptr);
+
+// reads requests from stdin and writes replies to stdout until eof or quit
+int runStdioServer(Solver& solver);
+// listens on a unix domain socket, one thread per connection, all sharing the solver
+int runUnixSocketServer(Solver& solver, const std::string& path);
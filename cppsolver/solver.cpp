@@ -0,0 +1,1025 @@
+#include "solver.hpp"
+#include "wordfilter.hpp"
+#include "feedbackpattern.hpp"
+#include "topkbound.hpp"
+#include "openingbook.hpp"
+#include "words.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <chrono>
+
+/**
+ * @brief Gets the original indexes of the smallest N numbers in a vector of floats.
+ *
+ * This function creates pairs of (value, original_index), sorts them based on value
+ * in ascending order, and then extracts the indexes of the top N elements.
+ *
+ * @param vec The input vector of float numbers.
+ * @param n The number of smallest elements to find indexes for.
+ * @return A vector of integers, representing the original indexes of the smallest N numbers.
+ *         The indexes are returned in the order of their corresponding values (smallest first).
+ *         Returns an empty vector if n <= 0 or the input vector is empty.
+ */
+std::vector<int> get_smallest_n_indexes(const std::vector<float>& vec, int n) {
+    // Handle edge cases: n is non-positive or vector is empty
+    if (n <= 0 || vec.empty()) {
+        return {};
+    }
+
+    // Ensure n doesn't exceed the vector's size
+    n = std::min(n, static_cast<int>(vec.size()));
+
+    // 1. Create a vector of pairs: {value, original_index}
+    std::vector<std::pair<float, int>> indexed_values;
+    indexed_values.reserve(vec.size()); // Pre-allocate memory for efficiency
+    for (int i = 0; i < vec.size(); ++i) {
+        indexed_values.push_back({ vec[i], i });
+    }
+
+    // 2. Partially sort the vector of pairs.
+    //    We only need the top 'n' elements to be in their correct sorted positions.
+    //    We sort in ascending order of float value. If values are equal,
+    //    we can use the index for stable ordering (e.g., smaller index first).
+    std::partial_sort(indexed_values.begin(),
+        indexed_values.begin() + n, // Sort only up to this point
+        indexed_values.end(),
+        [](const std::pair<float, int>& a, const std::pair<float, int>& b) {
+            if (a.first != b.first) {
+                return a.first < b.first; // <<--- CHANGED: Sort by value in ASCENDING order
+            }
+            // For tie-breaking (same value), prefer the smaller original index
+            return a.second < b.second;
+        });
+
+    // 3. Extract the indexes from the first 'n' elements of the partially sorted vector
+    std::vector<int> result_indexes;
+    result_indexes.reserve(n); // Pre-allocate memory
+    for (int i = 0; i < n; ++i) {
+        result_indexes.push_back(indexed_values[i].second);
+    }
+
+    return result_indexes;
+}
+
+//jobs per pool worker between deadline checks, small enough that a check comes every few hundred microseconds
+//on a first turn, large enough that the workers rarely wait at a slice boundary
+static constexpr size_t DEADLINE_SLICE_JOBS_PER_THREAD = 16;
+
+//every answer leaves at least itself as a candidate (in histogram terms it grows sum(bucket^2) by at least one)
+//so after done of total answers a guess's sum can't end up below partialSum + (total - done)
+static inline bool prunable(const TopKBound* topK, int64_t partialSum, size_t done, size_t total) {
+    return topK != nullptr && topK->canPrune(partialSum + (int64_t)(total - done));
+}
+
+//finished guesses go to the top k collector, if there is one
+static inline void offerTopK(TopKBound* topK, int64_t sum, int guessIdx) {
+    if (topK != nullptr) topK->offer(ThreadPool::currentThreadIndex(), sum, guessIdx);
+}
+
+static inline void markPruned(HistogramMetrics* output) {
+    output->expectedSize = std::numeric_limits<float>::infinity();
+}
+
+//answers between prune checks in the histogram jobs, the checks walk or update the buckets so they aren't free
+constexpr size_t PRUNE_CHECK_INTERVAL = 256;
+//the SIMD histogram kernels restart their sub histograms every call, so they get bigger slices (a multiple of 64)
+constexpr size_t HYPERPACKED_PRUNE_SLICE = 512;
+
+struct ScalarJobParams {
+    const std::string* word;
+    HistogramMetrics* output;
+    const std::vector<std::string>* wordlist;
+    int guessIdx;
+    TopKBound* topK; //nullptr scores to completion
+
+    ScalarJobParams() = default;
+    ScalarJobParams(const std::string* word, HistogramMetrics* out, const std::vector<std::string>* wordlist, int guessIdx, TopKBound* topK)
+        : word{ word }, output{ out }, wordlist{ wordlist }, guessIdx{ guessIdx }, topK{ topK } {}
+};
+
+//no SSE4.2 needed, for older hosts
+//having multiple threads access the same filtered words array might cause cache issues lol
+void scalar_countAvgRemaining_pooljob(void* param, void* /*threadlocalstorage*/) {
+    ScalarJobParams& params = *((ScalarJobParams*)param);
+    const std::vector<std::string>& wordlist = *params.wordlist;
+
+    int64_t sum = 0;
+    for (size_t i = 0; i < wordlist.size(); i++) {
+        if (prunable(params.topK, sum, i, wordlist.size())) {
+            markPruned(params.output);
+            return;
+        }
+        WordFilter tempFilter{ wordlist[i], *params.word };
+        sum += tempFilter.filterWordsCount(wordlist);
+    }
+
+    params.output->sumSquares = sum;
+    params.output->expectedSize = (float)sum / (float)wordlist.size();
+    offerTopK(params.topK, sum, params.guessIdx);
+}
+
+struct CountAvgRemainingJobParams {
+    char word[5];
+    HistogramMetrics* output;
+    size_t wordsInList;
+    int guessIdx;
+    TopKBound* topK; //nullptr scores to completion
+
+    CountAvgRemainingJobParams() = default;
+    CountAvgRemainingJobParams(const char* word, HistogramMetrics* out, size_t wordlistSize, int guessIdx, TopKBound* topK)
+        : output{ out }, wordsInList{ wordlistSize }, guessIdx{ guessIdx }, topK{ topK } {
+        std::memcpy(this->word, word, 5);
+    }
+};
+
+void countAvgRemaining_pooljob(void* param, void* threadlocalstorage) {
+    CountAvgRemainingJobParams& params = *((CountAvgRemainingJobParams*)param);
+
+    int64_t sum = 0;
+
+    for (int i = 0; i < params.wordsInList; i++) {
+        if (prunable(params.topK, sum, i, params.wordsInList)) {
+            markPruned(params.output);
+            return;
+        }
+        WordFilter tempFilter{ (char*)&(((unsigned char*)threadlocalstorage)[i * 5]), params.word };
+        sum += tempFilter.optimized_filterWordsCount(((unsigned char*)threadlocalstorage), params.wordsInList, nullptr);
+    }
+
+    params.output->sumSquares = sum;
+    params.output->expectedSize = (float)sum / (float)params.wordsInList;
+    offerTopK(params.topK, sum, params.guessIdx);
+}
+
+//word idx of a hyperpacked list, the letters sit packwidth bytes apart
+static inline void hyperpackedWord(const unsigned char* hyperpacked_wordlist, int packwidth, size_t idx, char* word) {
+    const unsigned char* batch = &(hyperpacked_wordlist[(idx / packwidth) * packwidth * 5 + (idx % packwidth)]);
+    for (int j = 0; j < 5; j++) {
+        word[j] = (char)batch[j * packwidth];
+    }
+}
+
+typedef void (*HyperpackedBlockFilterKernel)(const char* guess, const char* solutions, int solutionCount, const unsigned char* hyperpacked_wordlist, size_t words, int* counts);
+
+//one pass over the list per block of WordFilter::filterBlockSize answers instead of one per answer
+//pruning is checked between blocks
+static void hyperpackedBlockFilterJob(const CountAvgRemainingJobParams& params, const unsigned char* hyperpacked_wordlist, int packwidth, HyperpackedBlockFilterKernel kernel) {
+    const int blockSize = WordFilter::filterBlockSize;
+
+    int64_t sum = 0;
+
+    char solutions[blockSize * 5];
+    int counts[blockSize];
+    for (size_t begin = 0; begin < params.wordsInList; begin += blockSize) {
+        if (prunable(params.topK, sum, begin, params.wordsInList)) {
+            markPruned(params.output);
+            return;
+        }
+
+        int solutionCount = (int)std::min<size_t>(blockSize, params.wordsInList - begin);
+        for (int s = 0; s < solutionCount; s++) {
+            hyperpackedWord(hyperpacked_wordlist, packwidth, begin + s, &(solutions[s * 5]));
+        }
+        kernel(params.word, solutions, solutionCount, hyperpacked_wordlist, params.wordsInList, counts);
+
+        for (int s = 0; s < solutionCount; s++) sum += counts[s];
+    }
+
+    params.output->sumSquares = sum;
+    params.output->expectedSize = (float)sum / (float)params.wordsInList;
+    offerTopK(params.topK, sum, params.guessIdx);
+}
+
+void hyperavx_countAvgRemaining_pooljob(void* param, void* threadlocalstorage) {
+    CountAvgRemainingJobParams& params = *((CountAvgRemainingJobParams*)param);
+
+    hyperpackedBlockFilterJob(params, (unsigned char*)threadlocalstorage, 32, &WordFilter::hyperpacked_blockFilterWordsCount);
+}
+
+void hyperavx512_countAvgRemaining_pooljob(void* param, void* threadlocalstorage) {
+    CountAvgRemainingJobParams& params = *((CountAvgRemainingJobParams*)param);
+
+    hyperpackedBlockFilterJob(params, (unsigned char*)threadlocalstorage, 64, &WordFilter::hyperpacked_blockFilterWordsCount_AVX512);
+}
+
+typedef void (*HyperpackedHistogramKernel)(const char* guess, const unsigned char* hyperpacked_wordlist, size_t words, int* histogram);
+
+//whole list in one kernel call, or slice by slice with a prune check between them
+static bool hyperpackedPatternHistogram(const CountAvgRemainingJobParams& params, const unsigned char* hyperpacked_wordlist, HyperpackedHistogramKernel kernel, int* histogram) {
+    size_t firstSlice = (params.topK == nullptr) ? params.wordsInList : std::min(HYPERPACKED_PRUNE_SLICE, params.wordsInList);
+    kernel(params.word, hyperpacked_wordlist, firstSlice, histogram);
+    if (firstSlice == params.wordsInList) return true;
+
+    int64_t sumSquares = 0;
+    for (int c = 0; c < FEEDBACK_CODE_COUNT; c++) {
+        sumSquares += (int64_t)histogram[c] * histogram[c];
+    }
+
+    int sliceHistogram[FEEDBACK_CODE_COUNT];
+    for (size_t begin = firstSlice; begin < params.wordsInList; begin += HYPERPACKED_PRUNE_SLICE) {
+        if (prunable(params.topK, sumSquares, begin, params.wordsInList)) return false;
+
+        //slices start on a batch, so the kernel sees an ordinary (shorter) hyperpacked list
+        size_t words = std::min(HYPERPACKED_PRUNE_SLICE, params.wordsInList - begin);
+        kernel(params.word, &(hyperpacked_wordlist[begin * 5]), words, sliceHistogram);
+
+        //(h + d)^2 - h^2 = d(2h + d)
+        for (int c = 0; c < FEEDBACK_CODE_COUNT; c++) {
+            sumSquares += (int64_t)sliceHistogram[c] * (2 * histogram[c] + sliceHistogram[c]);
+            histogram[c] += sliceHistogram[c];
+        }
+    }
+    return true;
+}
+
+void hyperavx_pattern_countAvgRemaining_pooljob(void* param, void* threadlocalstorage) {
+    CountAvgRemainingJobParams& params = *((CountAvgRemainingJobParams*)param);
+
+    int histogram[FEEDBACK_CODE_COUNT];
+    if (!hyperpackedPatternHistogram(params, ((unsigned char*)threadlocalstorage), &hyperpacked_feedbackHistogram, histogram)) {
+        markPruned(params.output);
+        return;
+    }
+
+    *params.output = histogramMetrics(histogram, params.wordsInList);
+    offerTopK(params.topK, params.output->sumSquares, params.guessIdx);
+}
+
+void hyperavx512_pattern_countAvgRemaining_pooljob(void* param, void* threadlocalstorage) {
+    CountAvgRemainingJobParams& params = *((CountAvgRemainingJobParams*)param);
+
+    int histogram[FEEDBACK_CODE_COUNT];
+    if (!hyperpackedPatternHistogram(params, ((unsigned char*)threadlocalstorage), &hyperpacked_feedbackHistogram_AVX512, histogram)) {
+        markPruned(params.output);
+        return;
+    }
+
+    *params.output = histogramMetrics(histogram, params.wordsInList);
+    offerTopK(params.topK, params.output->sumSquares, params.guessIdx);
+}
+
+struct PatternJobParams {
+    char word[5];
+    HistogramMetrics* output;
+    const PatternWordlist* wordlist;
+    int guessIdx;
+    TopKBound* topK; //nullptr scores to completion
+
+    PatternJobParams() = default;
+    PatternJobParams(const char* word, HistogramMetrics* out, const PatternWordlist* list, int guessIdx, TopKBound* topK)
+        : output{ out }, wordlist{ list }, guessIdx{ guessIdx }, topK{ topK } {
+        std::memcpy(this->word, word, 5);
+    }
+};
+
+//one pass over the answers per guess, buckets answers by feedback code
+void pattern_countAvgRemaining_pooljob(void* param, void* /*threadlocalstorage*/) {
+    PatternJobParams& params = *((PatternJobParams*)param);
+    size_t answers = params.wordlist->size();
+
+    int histogram[FEEDBACK_CODE_COUNT];
+    int64_t sumSquares = 0;
+    if (params.topK == nullptr) {
+        params.wordlist->buildHistogram(params.word, histogram);
+    }
+    else {
+        std::memset(histogram, 0, sizeof(histogram));
+        for (size_t begin = 0; begin < answers; begin += PRUNE_CHECK_INTERVAL) {
+            if (prunable(params.topK, sumSquares, begin, answers)) {
+                markPruned(params.output);
+                return;
+            }
+            sumSquares += params.wordlist->accumulateHistogram(params.word, begin, std::min(begin + PRUNE_CHECK_INTERVAL, answers), histogram);
+        }
+    }
+
+    *params.output = histogramMetrics(histogram, answers);
+    offerTopK(params.topK, params.output->sumSquares, params.guessIdx);
+}
+
+struct PatternMatrixJobParams {
+    size_t guessIdx;
+    HistogramMetrics* output;
+    const PatternMatrix* matrix;
+    const int* answerIdxs; //nullptr for every answer
+    size_t answers;
+    TopKBound* topK; //nullptr scores to completion
+
+    PatternMatrixJobParams() = default;
+    PatternMatrixJobParams(size_t guess, HistogramMetrics* out, const PatternMatrix* matrix, const int* answerIdxs, size_t answers, TopKBound* topK)
+        : guessIdx{ guess }, output{ out }, matrix{ matrix }, answerIdxs{ answerIdxs }, answers{ answers }, topK{ topK } {}
+};
+
+//same as pattern_countAvgRemaining_pooljob but reads precomputed codes
+void patternmatrix_countAvgRemaining_pooljob(void* param, void* /*threadlocalstorage*/) {
+    PatternMatrixJobParams& params = *((PatternMatrixJobParams*)param);
+
+    int histogram[FEEDBACK_CODE_COUNT];
+    int64_t sumSquares = 0;
+    if (params.topK == nullptr) {
+        params.matrix->buildHistogram(params.guessIdx, params.answerIdxs, params.answers, histogram);
+    }
+    else {
+        std::memset(histogram, 0, sizeof(histogram));
+        for (size_t begin = 0; begin < params.answers; begin += PRUNE_CHECK_INTERVAL) {
+            if (prunable(params.topK, sumSquares, begin, params.answers)) {
+                markPruned(params.output);
+                return;
+            }
+            sumSquares += params.matrix->accumulateHistogram(params.guessIdx, params.answerIdxs, begin, std::min(begin + PRUNE_CHECK_INTERVAL, params.answers), histogram);
+        }
+    }
+
+    *params.output = histogramMetrics(histogram, params.answers);
+    offerTopK(params.topK, params.output->sumSquares, (int)params.guessIdx);
+}
+
+struct FollowUpJobParams {
+    const FeedbackLookup* lookup;
+    size_t searchWords;
+    const int* answerIdxs;
+    size_t answers;
+    float* output;
+
+    FollowUpJobParams() = default;
+    FollowUpJobParams(const FeedbackLookup* lookup, size_t searchWords, const int* answerIdxs, size_t answers, float* out)
+        : lookup{ lookup }, searchWords{ searchWords }, answerIdxs{ answerIdxs }, answers{ answers }, output{ out } {}
+};
+
+//best follow-up for one feedback bucket of the lookahead
+void followUp_pooljob(void* param, void* /*threadlocalstorage*/) {
+    FollowUpJobParams& params = *((FollowUpJobParams*)param);
+    *params.output = followUpGuesses(*params.lookup, params.searchWords, params.answerIdxs, params.answers);
+}
+
+struct MultiBoardJobParams {
+    const MultiBoardCandidates* candidates;
+    const FeedbackLookup* lookup;
+    int guessIdx;
+    MultiBoardGuess* output;
+
+    MultiBoardJobParams() = default;
+    MultiBoardJobParams(const MultiBoardCandidates* candidates, const FeedbackLookup* lookup, int guessIdx, MultiBoardGuess* out)
+        : candidates{ candidates }, lookup{ lookup }, guessIdx{ guessIdx }, output{ out } {}
+};
+
+void multiBoard_pooljob(void* param, void* /*threadlocalstorage*/) {
+    MultiBoardJobParams& params = *((MultiBoardJobParams*)param);
+    *params.output = params.candidates->score(*params.lookup, params.guessIdx);
+}
+
+WordFilter playedTurnsFilter(const WordFilter& filter, const std::vector<std::pair<std::string, unsigned char>>& turns) {
+    std::vector<WordFilter> filters{ filter };
+    for (const std::pair<std::string, unsigned char>& turn : turns) {
+        unsigned char states[5];
+        feedbackCodeStates(turn.second, states);
+        filters.push_back(WordFilter::fromFeedbackStates(turn.first.c_str(), states));
+    }
+    return WordFilter{ filters };
+}
+
+struct SampledJobParams {
+    const AnswerSample* sample;
+    const char* word;
+    size_t sampled;
+    ScoringMetric metric;
+    float z;
+    SampledGuess* output;
+
+    SampledJobParams() = default;
+    SampledJobParams(const AnswerSample* sample, const char* word, size_t sampled, ScoringMetric metric, float z, SampledGuess* out)
+        : sample{ sample }, word{ word }, sampled{ sampled }, metric{ metric }, z{ z }, output{ out } {}
+};
+
+void sampled_pooljob(void* param, void* /*threadlocalstorage*/) {
+    SampledJobParams& params = *((SampledJobParams*)param);
+
+    int histogram[FEEDBACK_CODE_COUNT];
+    params.sample->histogram(params.word, params.sampled, histogram);
+    sampledEstimate(histogram, params.sampled, params.sample->size(), params.metric, params.z, params.output->estimate, params.output->errorBar);
+    params.output->sampled = params.sampled;
+}
+
+Solver::Solver(const SolverConfig& config, const std::vector<std::string>& searchWords, const std::vector<std::string>& answerWords, const PackedWordTables* packedAnswers)
+    : config{ config }, searchWords{ searchWords }, answerWords{ answerWords }, answerWordIndex{ answerWords, config.simdLevel }, searchWordIndex{ searchWords, config.simdLevel }, pool{ config.threads }, packedAnswers{ packedAnswers }, answerPatterns{ answerWords }
+{
+    for (int i = 0; i < answerWords.size(); i++) {
+        this->answerIndex.emplace(answerWords[i], i);
+    }
+
+    //the matrix rows are indexed by the search words and the columns by the answer words
+    this->useMatrix = config.pattern_mode && config.pattern_matrix_mode;
+    if (this->useMatrix) {
+        if (!this->patternMatrix.openOrBuild(config.patternMatrixPath, searchWords, answerWords, config.patternMatrixMaxBytes)) {
+            if (this->patternMatrix.isOpen()) {
+                std::cerr << "could not map " << config.patternMatrixPath << ", using an in memory pattern matrix" << std::endl;
+            }
+            else {
+                std::cerr << "a " << searchWords.size() << " x " << answerWords.size() << " pattern matrix is over the size limit, scoring with the pattern kernels" << std::endl;
+                this->useMatrix = false;
+            }
+        }
+    }
+
+    //only the packed kernels read the shared storage: AVX2/AVX-512, and the SSE4.2 filter
+    const bool packedKernel = config.simdLevel >= SimdLevel::AVX2 || (config.simdLevel == SimdLevel::SSE42 && !config.pattern_mode);
+    if (packedAnswers != nullptr && !this->useMatrix && packedKernel) {
+        int packwidth = simdLevelPackWidth(config.simdLevel);
+        if (packwidth != 0) {
+            this->packedAnswersArena = CandidateArena::createStatic(packedAnswers->hyperpacked(packwidth), packedAnswers->hyperpackedBytes(packwidth), config.hugePages);
+        }
+        else {
+            this->packedAnswersArena = CandidateArena::createStatic(packedAnswers->flat(), packedAnswers->size() * 5, config.hugePages);
+        }
+    }
+}
+
+std::vector<std::string> Solver::filterAnswers(const WordFilter& filter) const
+{
+    std::vector<int> idxs = this->answerWordIndex.filterIndexes(filter);
+
+    std::vector<std::string> filtered;
+    filtered.reserve(idxs.size());
+    for (int i = 0; i < idxs.size(); i++) {
+        filtered.push_back(this->answerWords[idxs[i]]);
+    }
+    return filtered;
+}
+
+std::vector<int> Solver::legalGuesses(const WordFilter& filter) const
+{
+    return this->searchWordIndex.filterIndexes(filter);
+}
+
+std::vector<HistogramMetrics> Solver::scoreGuesses(const std::vector<std::string>& candidates, ScoringMetric metric)
+{
+    std::unique_lock<std::mutex> lock(this->solveLock);
+    return this->runScoring({ candidates.size(), &candidates }, metric, nullptr);
+}
+
+std::vector<HistogramMetrics> Solver::runScoring(const CandidateSet& candidates, ScoringMetric metric, TopKBound* topK, ScoringDeadline* deadline)
+{
+    const size_t candidateCount = candidates.count;
+    //the filter kernels only produce the expected size, every other metric needs the histogram
+    const bool pattern_mode = this->config.pattern_mode || metricNeedsHistogram(metric);
+    const SimdLevel simdLevel = this->config.simdLevel;
+    const bool hugePages = this->config.hugePages;
+    const bool hyperavx_mode = simdLevel >= SimdLevel::AVX2;
+    const bool avx512_mode = simdLevel == SimdLevel::AVX512;
+    const int packwidth = simdLevelPackWidth(simdLevel);
+
+    const std::vector<std::string>& selectedSearchWords = this->searchWords;
+
+    //one job per guess scored, in hard mode only the legal ones
+    const std::vector<int>* guessIdxs = candidates.guessIdxs;
+    const size_t jobCount = (guessIdxs != nullptr) ? guessIdxs->size() : selectedSearchWords.size();
+
+    //allocate task list
+    std::vector<CountAvgRemainingJobParams> jobParams;
+    jobParams.reserve(jobCount); jobParams.resize(jobCount);
+
+    std::vector<JobRecipe> sumJobs;
+    sumJobs.reserve(jobCount); sumJobs.resize(jobCount);
+
+    std::vector<PatternJobParams> patternJobParams;
+    std::vector<ScalarJobParams> scalarJobParams;
+    std::vector<PatternMatrixJobParams> patternMatrixJobParams;
+
+    std::vector<HistogramMetrics> metricsOutputs;
+    metricsOutputs.reserve(selectedSearchWords.size()); metricsOutputs.resize(selectedSearchWords.size());
+
+    //matrix columns for the candidates, candidates that aren't answer words can't use it
+    bool matrixUsable = this->useMatrix;
+    const int* filteredAnswerIdxs = candidates.answerIdxs;
+    std::vector<int> foundAnswerIdxs;
+    if (matrixUsable && filteredAnswerIdxs == nullptr) {
+        const std::vector<std::string>& filteredWords = *candidates.words;
+        foundAnswerIdxs.reserve(filteredWords.size());
+        for (int i = 0; i < filteredWords.size(); i++) {
+            auto found = this->answerIndex.find(filteredWords[i]);
+            if (found == this->answerIndex.end()) {
+                matrixUsable = false;
+                break;
+            }
+            foundAnswerIdxs.push_back(found->second);
+        }
+        filteredAnswerIdxs = foundAnswerIdxs.data();
+    }
+
+    //the answer tables already hold every answer packed, so the first turn of a game skips packing
+    const bool prepackedCandidates = (this->packedAnswersArena != nullptr) &&
+        ((candidates.words != nullptr) ? (*candidates.words == this->answerWords) : (candidateCount == this->answerWords.size()));
+
+    //shared between every job, only read from
+    PatternWordlist patternList{ (pattern_mode && !hyperavx_mode && !matrixUsable) ? *candidates.words : std::vector<std::string>{} };
+    if (matrixUsable) {
+        patternMatrixJobParams.resize(jobCount);
+        const int* answerIdxs = (candidateCount == this->answerWords.size()) ? nullptr : filteredAnswerIdxs;
+
+        //build jobs
+        for (int j = 0; j < jobCount; j++) {
+            int i = (guessIdxs != nullptr) ? (*guessIdxs)[j] : j;
+            patternMatrixJobParams[j] = PatternMatrixJobParams(i, &(metricsOutputs.data()[i]), &(this->patternMatrix), answerIdxs, candidateCount, topK);
+            sumJobs[j] = JobRecipe(&(patternMatrixJobParams.data()[j]), &patternmatrix_countAvgRemaining_pooljob);
+        }
+    }
+    else if (pattern_mode && !hyperavx_mode) {
+        patternJobParams.resize(jobCount);
+
+        //build jobs
+        for (int j = 0; j < jobCount; j++) {
+            int i = (guessIdxs != nullptr) ? (*guessIdxs)[j] : j;
+            patternJobParams[j] = PatternJobParams(selectedSearchWords[i].c_str(), &(metricsOutputs.data()[i]), &patternList, i, topK);
+            sumJobs[j] = JobRecipe(&(patternJobParams.data()[j]), &pattern_countAvgRemaining_pooljob);
+        }
+    }
+    else if (hyperavx_mode) {
+        //build optimally packed wordlist
+        // [w0c0], [w1c0], [w2c0], ... [w32c0]
+        // [w0c1], [w1c1], [w2c1], ... [w32c1]
+        // [w0c2], [w1c2], [w2c2], ... [w32c2]
+        // .
+        // .
+        // .
+        // [wNc5], [wNc2], [wNc5], ... [wNc5]
+
+        if (prepackedCandidates) {
+            this->pool.setSharedStorage(this->packedAnswersArena);
+        }
+        else if (candidates.hyperpacked != nullptr) {
+            this->pool.allocateSharedStorage(candidates.hyperpacked, hyperpackedListBytes<5>(candidateCount, packwidth), hugePages);
+        }
+        else {
+            size_t optimizedFilteredList_bytes = hyperpackedListBytes<5>(candidateCount, packwidth);
+            unsigned char* optimizedFilteredList = new unsigned char[optimizedFilteredList_bytes];
+            hyperpackWordList<5>(*candidates.words, packwidth, optimizedFilteredList);
+
+            this->pool.allocateSharedStorage(optimizedFilteredList, optimizedFilteredList_bytes, hugePages);
+            //can deallocate the packed list now
+            delete[] optimizedFilteredList;
+        }
+
+        //build jobs
+        for (int j = 0; j < jobCount; j++) {
+            int i = (guessIdxs != nullptr) ? (*guessIdxs)[j] : j;
+            jobParams[j] = CountAvgRemainingJobParams(selectedSearchWords[i].c_str(), &(metricsOutputs.data()[i]), candidateCount, i, topK);
+            if (pattern_mode && avx512_mode)
+                sumJobs[j] = JobRecipe(&(jobParams.data()[j]), &hyperavx512_pattern_countAvgRemaining_pooljob);
+            else if (pattern_mode)
+                sumJobs[j] = JobRecipe(&(jobParams.data()[j]), &hyperavx_pattern_countAvgRemaining_pooljob);
+            else if (avx512_mode)
+                sumJobs[j] = JobRecipe(&(jobParams.data()[j]), &hyperavx512_countAvgRemaining_pooljob);
+            else
+                sumJobs[j] = JobRecipe(&(jobParams.data()[j]), &hyperavx_countAvgRemaining_pooljob);
+        }
+    }
+    else if (simdLevel == SimdLevel::Scalar) {
+        scalarJobParams.resize(jobCount);
+
+        //build jobs
+        for (int j = 0; j < jobCount; j++) {
+            int i = (guessIdxs != nullptr) ? (*guessIdxs)[j] : j;
+            scalarJobParams[j] = ScalarJobParams(&(selectedSearchWords[i]), &(metricsOutputs.data()[i]), candidates.words, i, topK);
+            sumJobs[j] = JobRecipe(&(scalarJobParams.data()[j]), &scalar_countAvgRemaining_pooljob);
+        }
+    }
+    else {
+        if (prepackedCandidates) {
+            this->pool.setSharedStorage(this->packedAnswersArena);
+        }
+        else {
+            //allocate thread local storage
+            size_t optimizedFilteredList_bytes = candidateCount * 5;
+            unsigned char* optimizedFilteredList = new unsigned char[optimizedFilteredList_bytes];
+            flatpackWordList<5>(*candidates.words, optimizedFilteredList);
+
+            this->pool.allocateSharedStorage(optimizedFilteredList, optimizedFilteredList_bytes, hugePages);
+            delete[] optimizedFilteredList;
+        }
+
+        //build jobs
+        for (int j = 0; j < jobCount; j++) {
+            int i = (guessIdxs != nullptr) ? (*guessIdxs)[j] : j;
+            jobParams[j] = CountAvgRemainingJobParams(selectedSearchWords[i].c_str(), &(metricsOutputs.data()[i]), candidateCount, i, topK);
+            sumJobs[j] = JobRecipe(&(jobParams.data()[j]), &countAvgRemaining_pooljob);
+        }
+    }
+    if (deadline == nullptr) {
+        this->pool.QueueBatchTask(sumJobs.data(), sumJobs.size());
+        this->pool.WaitCompletion();
+    }
+    else {
+        //slices in job order with the deadline checked between them, the first slice always runs
+        const size_t slice = (size_t)this->pool.getThreadCount() * DEADLINE_SLICE_JOBS_PER_THREAD;
+        size_t queued = 0;
+        while (queued < sumJobs.size()) {
+            if (queued > 0 && std::chrono::steady_clock::now() >= deadline->at) break;
+
+            size_t jobs = std::min(slice, sumJobs.size() - queued);
+            this->pool.QueueBatchTask(&(sumJobs[queued]), (int)jobs);
+            this->pool.WaitCompletion();
+            queued += jobs;
+        }
+        deadline->evaluated = queued;
+    }
+
+    return metricsOutputs;
+}
+
+std::vector<ScoredGuess> Solver::rankGuesses(const std::vector<std::string>& candidates, int topK, ScoringMetric metric, const std::vector<int>* guessIdxs)
+{
+    std::unique_lock<std::mutex> lock(this->solveLock);
+    return this->rankCandidates({ candidates.size(), &candidates, nullptr, nullptr, guessIdxs }, topK, metric);
+}
+
+std::vector<ScoredGuess> Solver::rankGuesses(const WordFilter& filter, int topK, ScoringMetric metric, size_t* candidateCount, const std::vector<int>* guessIdxs)
+{
+    std::unique_lock<std::mutex> lock(this->solveLock);
+
+    const bool hyperavx_mode = this->config.simdLevel >= SimdLevel::AVX2;
+    CandidateSet candidates;
+
+    std::vector<int> idxs;
+    std::vector<std::string> words;
+    std::unique_ptr<unsigned char[]> hyperpacked;
+    if (this->openingBook != nullptr && guessIdxs == nullptr) {
+        //the book is checked on answer indexes, which the index gives in a few microseconds
+        idxs = this->answerWordIndex.filterIndexes(filter);
+        std::vector<ScoredGuess> booked;
+        if (this->bookRanking({ idxs.size(), nullptr, idxs.data() }, topK, metric, booked)) {
+            if (candidateCount != nullptr) *candidateCount = idxs.size();
+            return booked;
+        }
+    }
+
+    if (this->useMatrix) {
+        //the matrix only needs the answer indexes
+        if (this->openingBook == nullptr || guessIdxs != nullptr) idxs = this->answerWordIndex.filterIndexes(filter);
+        candidates = { idxs.size(), nullptr, idxs.data(), nullptr, guessIdxs };
+    }
+    else if (hyperavx_mode && this->packedAnswers != nullptr) {
+        //compact the packed answers straight into the layout the kernels read
+        int packwidth = simdLevelPackWidth(this->config.simdLevel);
+        hyperpacked.reset(new unsigned char[this->packedAnswers->hyperpackedBytes(packwidth)]);
+
+        size_t count = (packwidth == 64)
+            ? filter.hyperpacked_filterCompact_AVX512(this->packedAnswers->hyperpacked(packwidth), this->packedAnswers->size(), hyperpacked.get())
+            : filter.hyperpacked_filterCompact(this->packedAnswers->hyperpacked(packwidth), this->packedAnswers->size(), hyperpacked.get());
+        candidates = { count, nullptr, nullptr, hyperpacked.get(), guessIdxs };
+    }
+    else {
+        words = this->filterAnswers(filter);
+        candidates = { words.size(), &words, nullptr, nullptr, guessIdxs };
+    }
+
+    if (candidateCount != nullptr) *candidateCount = candidates.count;
+    return this->rankCandidates(candidates, topK, metric);
+}
+
+bool Solver::bookRanking(const CandidateSet& candidates, int topK, ScoringMetric metric, std::vector<ScoredGuess>& ranked) const
+{
+    const OpeningBook* book = this->openingBook;
+    //the book ranks every search word, a hard mode subset has its own ranking
+    if (book == nullptr || candidates.guessIdxs != nullptr || metric != book->getMetric() || topK > book->getTopK() || !book->holdsSetOfSize(candidates.count)) return false;
+
+    //book positions are sets of answers
+    const int* answerIdxs = candidates.answerIdxs;
+    std::vector<int> foundAnswerIdxs;
+    if (answerIdxs == nullptr) {
+        if (candidates.words == nullptr) return false;
+        foundAnswerIdxs.reserve(candidates.count);
+        for (const std::string& word : *candidates.words) {
+            auto found = this->answerIndex.find(word);
+            if (found == this->answerIndex.end()) return false;
+            foundAnswerIdxs.push_back(found->second);
+        }
+        answerIdxs = foundAnswerIdxs.data();
+    }
+
+    const std::vector<ScoredGuess>* booked = book->find(answerIdxs, candidates.count);
+    if (booked == nullptr) return false;
+    ranked.assign(booked->begin(), booked->begin() + std::min((size_t)std::max(topK, 0), booked->size()));
+    return true;
+}
+
+//the best guesses a TopKBound collected, best first
+static std::vector<ScoredGuess> boundRanking(const TopKBound& bound, const std::vector<HistogramMetrics>& scores, ScoringMetric metric) {
+    std::vector<ScoredGuess> ranked;
+    for (const std::pair<int64_t, int>& best : bound.merge()) {
+        const HistogramMetrics& metrics = scores[best.second];
+        ranked.push_back({ best.second, metricValue(metrics, metric), metrics });
+    }
+    return ranked;
+}
+
+//best topK of the scored guesses, guessIdxs ascending or nullptr when every search word was scored
+static std::vector<ScoredGuess> scoreRanking(const std::vector<HistogramMetrics>& scores, const std::vector<int>* guessIdxs, size_t candidateCount, int topK, ScoringMetric metric) {
+    std::vector<float> rankKeys((guessIdxs != nullptr) ? guessIdxs->size() : scores.size());
+    for (int i = 0; i < rankKeys.size(); i++) {
+        rankKeys[i] = metricRankKey(scores[(guessIdxs != nullptr) ? (*guessIdxs)[i] : i], metric, candidateCount);
+    }
+    std::vector<int> bestIdxs = get_smallest_n_indexes(rankKeys, topK);
+    if (guessIdxs != nullptr) {
+        for (int& idx : bestIdxs) idx = (*guessIdxs)[idx];
+    }
+
+    std::vector<ScoredGuess> ranked;
+    ranked.reserve(bestIdxs.size());
+    for (int i = 0; i < bestIdxs.size(); i++) {
+        const HistogramMetrics& metrics = scores[bestIdxs[i]];
+        ranked.push_back({ bestIdxs[i], metricValue(metrics, metric), metrics });
+    }
+    return ranked;
+}
+
+//cheap prior for the deadline ranking, most promising guess first, ties in search word order
+//a letter splits the candidates best when about half of them have it, so each guess letter is worth
+//min(have, don't) over the candidates, once in its position and once anywhere in the word
+static std::vector<int> letterFrequencyOrder(const std::vector<std::string>& candidates, const std::vector<std::string>& searchWords, const std::vector<int>* guessIdxs) {
+    const int n = (int)candidates.size();
+    int positional[5][32] = {};
+    int contained[32] = {};
+    for (const std::string& word : candidates) {
+        const unsigned char* letters = (const unsigned char*)word.c_str();
+        for (int p = 0; p < 5; p++) positional[p][letters[p] & 31]++;
+        uint32_t mask = wordLetterMask(letters);
+        for (int c = 0; c < 32; c++) contained[c] += (mask >> c) & 1;
+    }
+    for (int c = 0; c < 32; c++) {
+        for (int p = 0; p < 5; p++) positional[p][c] = std::min(positional[p][c], n - positional[p][c]);
+        contained[c] = std::min(contained[c], n - contained[c]);
+    }
+
+    size_t guesses = (guessIdxs != nullptr) ? guessIdxs->size() : searchWords.size();
+    std::vector<std::pair<int, int>> priors(guesses);
+    for (size_t j = 0; j < guesses; j++) {
+        int guessIdx = (guessIdxs != nullptr) ? (*guessIdxs)[j] : (int)j;
+        const unsigned char* letters = (const unsigned char*)searchWords[guessIdx].c_str();
+
+        int prior = 0;
+        for (int p = 0; p < 5; p++) prior += positional[p][letters[p] & 31];
+        uint32_t mask = wordLetterMask(letters);
+        while (mask != 0) {
+            prior += contained[lowestSetBit(mask)];
+            mask &= mask - 1;
+        }
+        priors[j] = { prior, guessIdx };
+    }
+    std::stable_sort(priors.begin(), priors.end(), [](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+        return a.first > b.first;
+    });
+
+    std::vector<int> order(guesses);
+    for (size_t j = 0; j < guesses; j++) order[j] = priors[j].second;
+    return order;
+}
+
+std::vector<ScoredGuess> Solver::rankCandidates(const CandidateSet& candidates, int topK, ScoringMetric metric)
+{
+    std::vector<ScoredGuess> booked;
+    if (this->bookRanking(candidates, topK, metric, booked)) return booked;
+    if (candidates.guessIdxs != nullptr && candidates.guessIdxs->empty()) return {};
+
+    //expected size is an integer sum that only grows while a guess is scored, so guesses that can't make the
+    //top k are dropped part way through and the workers keep the best k themselves
+    if (metric == ScoringMetric::ExpectedSize && topK > 0) {
+        TopKBound bound{ topK, this->pool.getThreadCount() };
+        std::vector<HistogramMetrics> scores = this->runScoring(candidates, metric, &bound);
+        return boundRanking(bound, scores, metric);
+    }
+
+    std::vector<HistogramMetrics> scores = this->runScoring(candidates, metric, nullptr);
+    return scoreRanking(scores, candidates.guessIdxs, candidates.count, topK, metric);
+}
+
+DeadlineRanking Solver::rankGuessesDeadline(const std::vector<std::string>& candidates, int topK, double budget, ScoringMetric metric, const std::vector<int>* guessIdxs)
+{
+    std::unique_lock<std::mutex> lock(this->solveLock);
+    auto start = std::chrono::steady_clock::now();
+
+    DeadlineRanking result;
+    result.total = (guessIdxs != nullptr) ? guessIdxs->size() : this->searchWords.size();
+    if (candidates.empty() || result.total == 0 || topK <= 0) return result;
+
+    //a book position is answered without scoring anything
+    if (guessIdxs == nullptr && this->bookRanking({ candidates.size(), &candidates }, topK, metric, result.guesses)) {
+        result.evaluated = result.total;
+        return result;
+    }
+
+    std::vector<int> order = letterFrequencyOrder(candidates, this->searchWords, guessIdxs);
+    ScoringDeadline deadline{ start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(budget)) };
+    CandidateSet candidateSet{ candidates.size(), &candidates, nullptr, nullptr, &order };
+
+    if (metric == ScoringMetric::ExpectedSize) {
+        //the prior puts strong guesses first, so the bound tightens early and most later jobs stop part way
+        TopKBound bound{ topK, this->pool.getThreadCount() };
+        std::vector<HistogramMetrics> scores = this->runScoring(candidateSet, metric, &bound, &deadline);
+        result.guesses = boundRanking(bound, scores, metric);
+    }
+    else {
+        std::vector<HistogramMetrics> scores = this->runScoring(candidateSet, metric, nullptr, &deadline);
+
+        //rank what was evaluated in search word order, so ties break the same way as a full ranking
+        std::vector<int> evaluated(order.begin(), order.begin() + deadline.evaluated);
+        std::sort(evaluated.begin(), evaluated.end());
+        result.guesses = scoreRanking(scores, &evaluated, candidates.size(), topK, metric);
+    }
+    result.evaluated = deadline.evaluated;
+    return result;
+}
+
+std::vector<LookaheadGuess> Solver::rankGuessesLookahead(const std::vector<std::string>& candidates, const LookaheadConfig& lookahead, ScoringMetric metric)
+{
+    std::unique_lock<std::mutex> lock(this->solveLock);
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<LookaheadGuess> ranked;
+    if (candidates.empty()) return ranked;
+
+    for (const ScoredGuess& guess : this->rankCandidates({ candidates.size(), &candidates }, lookahead.firstGuesses, metric)) {
+        ranked.push_back({ guess.guessIdx, guess.score, std::numeric_limits<float>::infinity(), false });
+    }
+
+    //the codes and the cache keys are by answer
+    std::vector<int> answerIdxs;
+    answerIdxs.reserve(candidates.size());
+    for (int i = 0; i < candidates.size(); i++) {
+        auto found = this->answerIndex.find(candidates[i]);
+        if (found == this->answerIndex.end()) return ranked;
+        answerIdxs.push_back(found->second);
+    }
+
+    FeedbackLookup lookup{ this->useMatrix ? &(this->patternMatrix) : nullptr, &(this->answerPatterns), &(this->searchWords) };
+
+    std::vector<std::vector<int>> buckets(FEEDBACK_CODE_COUNT);
+    std::vector<float> bucketGuesses(FEEDBACK_CODE_COUNT);
+    std::vector<CandidateBitset> bucketKeys(FEEDBACK_CODE_COUNT);
+    std::vector<FollowUpJobParams> followUpJobParams(FEEDBACK_CODE_COUNT);
+    std::vector<JobRecipe> followUpJobs;
+    std::vector<int> searchedCodes;
+
+    for (int g = 0; g < ranked.size(); g++) {
+        if (g > 0 && lookahead.timeBudget > 0 && std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >= lookahead.timeBudget) break;
+
+        for (std::vector<int>& bucket : buckets) bucket.clear();
+        for (int answerIdx : answerIdxs) {
+            buckets[lookup.code(ranked[g].guessIdx, answerIdx)].push_back(answerIdx);
+        }
+
+        //every bucket gets its own job, unless it is trivial or an earlier guess already searched it
+        followUpJobs.clear();
+        searchedCodes.clear();
+        for (int code = 0; code < FEEDBACK_CODE_COUNT; code++) {
+            const std::vector<int>& bucket = buckets[code];
+            bucketGuesses[code] = 0.0f;
+            if (bucket.empty() || code == SOLVED_FEEDBACK_CODE) continue;
+
+            if (bucket.size() <= 2) {
+                bucketGuesses[code] = candidateGuesses(bucket.size());
+                continue;
+            }
+
+            bucketKeys[code] = candidateBitset(bucket, this->answerWords.size());
+            if (this->lookaheadCache.find(bucketKeys[code], bucketGuesses[code])) continue;
+
+            followUpJobParams[code] = FollowUpJobParams(&lookup, this->searchWords.size(), bucket.data(), bucket.size(), &(bucketGuesses[code]));
+            followUpJobs.push_back(JobRecipe(&(followUpJobParams[code]), &followUp_pooljob));
+            searchedCodes.push_back(code);
+        }
+        if (!followUpJobs.empty()) {
+            this->pool.QueueBatchTask(followUpJobs.data(), followUpJobs.size());
+            this->pool.WaitCompletion();
+        }
+        for (int code : searchedCodes) {
+            this->lookaheadCache.insert(std::move(bucketKeys[code]), bucketGuesses[code]);
+        }
+
+        //the guess itself, then each bucket's follow-up weighted by how likely the bucket is
+        float expected = 1.0f;
+        for (int code = 0; code < FEEDBACK_CODE_COUNT; code++) {
+            expected += (float)buckets[code].size() / candidates.size() * bucketGuesses[code];
+        }
+        ranked[g].expectedGuesses = expected;
+        ranked[g].expanded = true;
+    }
+
+    //unexpanded guesses sit at infinity and keep their one ply order
+    std::stable_sort(ranked.begin(), ranked.end(), [](const LookaheadGuess& a, const LookaheadGuess& b) {
+        return a.expectedGuesses < b.expectedGuesses;
+    });
+    return ranked;
+}
+
+std::vector<SampledGuess> Solver::rankGuessesSampled(const std::vector<std::string>& candidates, int topK, ScoringMetric metric, const SamplingConfig& sampling, const std::vector<int>* guessIdxs)
+{
+    std::unique_lock<std::mutex> lock(this->solveLock);
+
+    if (candidates.empty() || topK <= 0 || !sampledMetric(metric)) return {};
+
+    AnswerSample sample{ candidates, sampling.seed, this->config.simdLevel };
+    const size_t sampleLimit = (sampling.maxSample > 0) ? sampling.maxSample : sample.size();
+
+    //lower keys rank first
+    const bool higherIsBetter = metric == ScoringMetric::Entropy;
+    auto rankKey = [higherIsBetter](const SampledGuess& guess) { return higherIsBetter ? -guess.estimate : guess.estimate; };
+
+    std::vector<SampledGuess> scores(this->searchWords.size());
+    std::vector<int> active;
+    if (guessIdxs != nullptr) active = *guessIdxs;
+    else {
+        active.resize(this->searchWords.size());
+        for (int i = 0; i < active.size(); i++) active[i] = i;
+    }
+
+    size_t sampled = sample.prefixSize(std::min(std::max<size_t>(sampling.initialSample, 1), sampleLimit));
+    std::vector<SampledJobParams> jobParams;
+    std::vector<JobRecipe> jobs;
+    std::vector<float> upperKeys;
+    while (!active.empty()) {
+        jobParams.resize(active.size());
+        jobs.resize(active.size());
+        for (int j = 0; j < active.size(); j++) {
+            int i = active[j];
+            scores[i].guessIdx = i;
+            jobParams[j] = SampledJobParams(&sample, this->searchWords[i].c_str(), sampled, metric, sampling.z, &(scores[i]));
+            jobs[j] = JobRecipe(&(jobParams[j]), &sampled_pooljob);
+        }
+        this->pool.QueueBatchTask(jobs.data(), jobs.size());
+        this->pool.WaitCompletion();
+
+        size_t next = sample.prefixSize(std::min(sampled * 2, sampleLimit));
+        if (next <= sampled || active.size() <= topK) break;
+
+        //a guess can still make the top k while its best case beats the k-th best worst case
+        upperKeys.resize(active.size());
+        for (int j = 0; j < active.size(); j++) {
+            upperKeys[j] = rankKey(scores[active[j]]) + scores[active[j]].errorBar;
+        }
+        std::nth_element(upperKeys.begin(), upperKeys.begin() + (topK - 1), upperKeys.end());
+        float bound = upperKeys[topK - 1];
+
+        std::vector<int> overlapping;
+        for (int i : active) {
+            if (rankKey(scores[i]) - scores[i].errorBar <= bound) overlapping.push_back(i);
+        }
+        active.swap(overlapping);
+        if (active.size() <= topK) break;
+
+        sampled = next;
+    }
+
+    std::vector<SampledGuess> ranked;
+    ranked.reserve(active.size());
+    for (int i : active) ranked.push_back(scores[i]);
+    std::sort(ranked.begin(), ranked.end(), [&](const SampledGuess& a, const SampledGuess& b) {
+        if (rankKey(a) != rankKey(b)) return rankKey(a) < rankKey(b);
+        return a.guessIdx < b.guessIdx;
+    });
+    if (ranked.size() > topK) ranked.resize(topK);
+    return ranked;
+}
+
+std::vector<MultiBoardGuess> Solver::rankGuessesMultiBoard(const std::vector<std::vector<std::string>>& boards, int topK, MultiBoardObjective objective)
+{
+    std::unique_lock<std::mutex> lock(this->solveLock);
+
+    //boards are merged on answer index
+    std::vector<std::vector<int>> boardAnswerIdxs(boards.size());
+    int unsolvedBoards = 0;
+    for (int b = 0; b < boards.size(); b++) {
+        for (const std::string& word : boards[b]) {
+            auto found = this->answerIndex.find(word);
+            if (found == this->answerIndex.end()) return {};
+            boardAnswerIdxs[b].push_back(found->second);
+        }
+        std::sort(boardAnswerIdxs[b].begin(), boardAnswerIdxs[b].end());
+        if (!boardAnswerIdxs[b].empty()) unsolvedBoards++;
+    }
+    if (unsolvedBoards == 0 || unsolvedBoards > MAX_BOARDS || topK <= 0) return {};
+
+    MultiBoardCandidates candidates{ boardAnswerIdxs };
+    FeedbackLookup lookup{ this->useMatrix ? &(this->patternMatrix) : nullptr, &(this->answerPatterns), &(this->searchWords) };
+
+    std::vector<MultiBoardGuess> scores(this->searchWords.size());
+    std::vector<MultiBoardJobParams> jobParams(this->searchWords.size());
+    std::vector<JobRecipe> jobs(this->searchWords.size());
+    for (int i = 0; i < this->searchWords.size(); i++) {
+        jobParams[i] = MultiBoardJobParams(&candidates, &lookup, i, &(scores.data()[i]));
+        jobs[i] = JobRecipe(&(jobParams.data()[i]), &multiBoard_pooljob);
+    }
+    this->pool.QueueBatchTask(jobs.data(), jobs.size());
+    this->pool.WaitCompletion();
+
+    size_t best = std::min((size_t)topK, scores.size());
+    std::partial_sort(scores.begin(), scores.begin() + best, scores.end(), [objective](const MultiBoardGuess& a, const MultiBoardGuess& b) {
+        return multiBoardRanksBefore(a, b, objective);
+    });
+    scores.resize(best);
+    for (MultiBoardGuess& guess : scores) guess.score = multiBoardObjectiveValue(guess, objective);
+    return scores;
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <mutex>
+#include <chrono>
+#include <thread>
+
+#include "threadpool.h"
+#include "cpufeatures.hpp"
+#include "patternmatrix.hpp"
+#include "candidatearena.hpp"
+#include "scoringmetrics.hpp"
+#include "wordindex.hpp"
+#include "lookahead.hpp"
+#include "multiboard.hpp"
+#include "sampledscoring.hpp"
+
+class PackedWordTables;
+class TopKBound;
+class OpeningBook;
+
+std::vector<int> get_smallest_n_indexes(const std::vector<float>& vec, int n);
+
+// filter merged with the filter each turn's feedback gives: the answers still possible after the turns,
+// and what a hard mode guess has to keep
+WordFilter playedTurnsFilter(const WordFilter& filter, const std::vector<std::pair<std::string, unsigned char>>& turns);
+
+// std::thread::hardware_concurrency(), 1 when the OS doesn't say
+inline int defaultThreadCount() {
+    unsigned int threads = std::thread::hardware_concurrency();
+    return (threads == 0) ? 1 : (int)threads;
+}
+
+struct SolverConfig {
+    SimdLevel simdLevel = SimdLevel::Scalar;
+    // score guesses by bucketing answers on their feedback code (same results as the filter modes)
+    bool pattern_mode = true;
+    // read the codes from the search words x answer words matrix file instead of computing them
+    bool pattern_matrix_mode = true;
+    std::string patternMatrixPath = "patternmatrix.bin";
+    // larger matrices fall back to the pattern kernels
+    size_t patternMatrixMaxBytes = PATTERN_MATRIX_DEFAULT_MAX_BYTES;
+    // back the shared candidate list with 2MB pages when the OS allows it
+    bool hugePages = false;
+    // pool size, every hardware thread by default
+    int threads = defaultThreadCount();
+};
+
+struct ScoredGuess {
+    int guessIdx; // index into the search words
+    float score;  // the ranking metric's value, see metricValue
+    HistogramMetrics metrics; // every metric, only expectedSize is set by the filter kernels
+};
+
+struct DeadlineRanking {
+    std::vector<ScoredGuess> guesses; // best first, out of the guesses evaluated
+    size_t evaluated = 0;             // guesses scored (or pruned from the top k) before the deadline
+    size_t total = 0;                 // guesses there were to score
+};
+
+// scores every search word against a set of remaining answers
+// the pool and pattern matrix stay warm between calls, calls from several threads are serialized
+class Solver {
+public:
+    // packedAnswers, if given, must hold the same words as answerWords, its packed tables are used
+    // whenever every answer is still a candidate
+    Solver(const SolverConfig& config, const std::vector<std::string>& searchWords, const std::vector<std::string>& answerWords, const PackedWordTables* packedAnswers = nullptr);
+
+    // candidates are answer words, the result is indexed like the search words
+    // metrics other than ExpectedSize always use the pattern kernels, whatever pattern_mode says
+    std::vector<HistogramMetrics> scoreGuesses(const std::vector<std::string>& candidates, ScoringMetric metric = ScoringMetric::ExpectedSize);
+    // best topK guesses by metric, best first
+    // ranking by ExpectedSize stops scoring a guess as soon as it can't make the top k, same result as a full scoreGuesses
+    // guessIdxs, if given, are the only search words scored (ascending, see legalGuesses), the book is skipped then
+    std::vector<ScoredGuess> rankGuesses(const std::vector<std::string>& candidates, int topK, ScoringMetric metric = ScoringMetric::ExpectedSize, const std::vector<int>* guessIdxs = nullptr);
+    // same ranking over the answer words passing filter
+    // the candidates go straight from the answer tables to the kernels' layout, without building their strings
+    // candidateCount, if given, receives how many answers passed
+    std::vector<ScoredGuess> rankGuesses(const WordFilter& filter, int topK, ScoringMetric metric = ScoringMetric::ExpectedSize, size_t* candidateCount = nullptr, const std::vector<int>* guessIdxs = nullptr);
+
+    // hard mode guesses: indexes of the search words passing filter, ascending, read from the search word index
+    // late in a game this leaves a few hundred guesses to schedule instead of every search word
+    std::vector<int> legalGuesses(const WordFilter& filter) const;
+
+    // two ply ranking: the lookahead.firstGuesses best guesses by metric, reranked by the expected number of
+    // guesses to solve when every feedback bucket they leave gets its best follow-up (see followUpGuesses)
+    // best first, guesses the time budget didn't reach come last in one ply order
+    // candidates must be answer words, otherwise nothing is expanded
+    std::vector<LookaheadGuess> rankGuessesLookahead(const std::vector<std::string>& candidates, const LookaheadConfig& lookahead, ScoringMetric metric = ScoringMetric::ExpectedSize);
+
+    // anytime ranking for a fixed latency: guesses are scored in order of a cheap letter frequency prior over the
+    // candidates until budget seconds have passed since the call, then the best topK of those evaluated come back
+    // the deadline is checked between slices of jobs, so it can overrun by one slice, and at least one slice always runs
+    // guessIdxs as for rankGuesses
+    DeadlineRanking rankGuessesDeadline(const std::vector<std::string>& candidates, int topK, double budget, ScoringMetric metric = ScoringMetric::ExpectedSize, const std::vector<int>* guessIdxs = nullptr);
+
+    // approximate ranking for candidate sets too large to score exactly, ExpectedSize or Entropy only (see sampledMetric)
+    // every guess is estimated from a stratified sample of the candidates, then only the guesses whose confidence
+    // interval still overlaps the top k are rescored on a sample twice as large, until the top k separate from
+    // the rest, the sample covers every candidate (exact values, no error bars) or it reaches sampling.maxSample
+    // best first by estimate, out of the guesses refined last
+    // guessIdxs as for rankGuesses
+    std::vector<SampledGuess> rankGuessesSampled(const std::vector<std::string>& candidates, int topK, ScoringMetric metric, const SamplingConfig& sampling, const std::vector<int>* guessIdxs = nullptr);
+
+    // best topK guesses for several boards played at once, boards holds each board's candidates (answer words)
+    // solved boards are passed empty and take no work, every distinct candidate is coded once per guess
+    // empty if a candidate isn't an answer word, no board is unsolved or more than MAX_BOARDS are
+    std::vector<MultiBoardGuess> rankGuessesMultiBoard(const std::vector<std::vector<std::string>>& boards, int topK, MultiBoardObjective objective);
+
+    // rankGuesses answers from the book when the candidates are a book position and it was built with the same
+    // metric and at least topK guesses, nullptr to always search, the book must outlive its use here
+    void setOpeningBook(const OpeningBook* book) { this->openingBook = book; }
+
+    // answer words passing filter, in answer list order, read from the answer index instead of scanning every word
+    std::vector<std::string> filterAnswers(const WordFilter& filter) const;
+
+    const std::vector<std::string>& getSearchWords() const { return this->searchWords; }
+    const std::vector<std::string>& getAnswerWords() const { return this->answerWords; }
+    const SolverConfig& getConfig() const { return this->config; }
+
+private:
+    // the answers a scoring run is over
+    // words can only be left out when the kernels that run don't need them, see rankGuesses(filter)
+    struct CandidateSet {
+        size_t count = 0;
+        const std::vector<std::string>* words = nullptr;
+        const int* answerIdxs = nullptr;            // answer list indexes, looked up from words if nullptr
+        const unsigned char* hyperpacked = nullptr; // already hyperpacked at the simd level's pack width, packed from words if nullptr
+        const std::vector<int>* guessIdxs = nullptr; // search words to score, queued in this order, every one if nullptr
+    };
+
+    struct ScoringDeadline {
+        std::chrono::steady_clock::time_point at;
+        size_t evaluated = 0; // jobs run, in candidates.guessIdxs order
+    };
+
+    // topK, if given, collects the best guesses and lets jobs give up early, pruned guesses aren't scored
+    // guesses left out of candidates.guessIdxs keep default metrics
+    // deadline, if given, stops queuing jobs once it passes, guesses never queued keep default metrics
+    std::vector<HistogramMetrics> runScoring(const CandidateSet& candidates, ScoringMetric metric, TopKBound* topK, ScoringDeadline* deadline = nullptr);
+    std::vector<ScoredGuess> rankCandidates(const CandidateSet& candidates, int topK, ScoringMetric metric);
+    // the book's ranking cut to topK, false if the candidates aren't a book position
+    bool bookRanking(const CandidateSet& candidates, int topK, ScoringMetric metric, std::vector<ScoredGuess>& ranked) const;
+
+    SolverConfig config;
+    const std::vector<std::string>& searchWords;
+    const std::vector<std::string>& answerWords;
+    std::unordered_map<std::string, int> answerIndex;
+    WordIndex answerWordIndex;
+    WordIndex searchWordIndex; //hard mode guess filtering
+
+    ThreadPool pool;
+    PatternMatrix patternMatrix;
+    bool useMatrix;
+
+    const PackedWordTables* packedAnswers;
+
+    PatternWordlist answerPatterns; //codes for the lookahead when there is no matrix
+    TranspositionCache lookaheadCache;
+    const OpeningBook* openingBook = nullptr;
+    std::shared_ptr<const CandidateArena> packedAnswersArena; //the prepacked answer tables, nullptr if unused
+
+    std::mutex solveLock;
+};
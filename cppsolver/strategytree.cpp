@@ -0,0 +1,328 @@
+#include "strategytree.hpp"
+#include "patternmatrix.hpp"
+#include "solver.hpp"
+#include "words.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+#include <unordered_map>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <process.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static const char strategyTreeMagic[8] = { 'W', 'S', 'S', 'T', 'R', 'T', 'R', 'E' };
+
+//guesses looked at for a tie with a candidate, a candidate can end the game on the spot
+constexpr int TIE_BREAK_GUESSES = 32;
+
+struct BuildNode {
+    int guessIdx = -1;
+    int depth = 1; //guesses played once this node's guess is
+    std::vector<unsigned char> codes;
+    std::vector<int> children;
+};
+
+static inline uint32_t nodeBytes(const BuildNode& node) {
+    uint32_t childCount = (uint32_t)node.children.size();
+    return 8 + 4 * childCount + ((childCount + 3) & ~3u);
+}
+
+//best guess for the answers still possible at a node, -1 if no search word is an answer to fall back on
+static int pickGuess(Solver& solver, const std::unordered_map<std::string, int>& searchIndex, const std::vector<int>& answerIdxs, ScoringMetric metric) {
+    const std::vector<std::string>& answerWords = solver.getAnswerWords();
+    const std::vector<std::string>& searchWords = solver.getSearchWords();
+
+    std::vector<std::string> candidates;
+    candidates.reserve(answerIdxs.size());
+    for (int idx : answerIdxs) candidates.push_back(answerWords[idx]);
+
+    //nothing splits two candidates better than guessing one of them
+    if (candidates.size() <= 2) {
+        auto found = searchIndex.find(candidates[0]);
+        if (found != searchIndex.end()) return found->second;
+    }
+
+    std::vector<ScoredGuess> ranked = solver.rankGuesses(candidates, TIE_BREAK_GUESSES, metric);
+    if (ranked.empty()) return -1;
+    for (const ScoredGuess& guess : ranked) {
+        if (guess.score != ranked[0].score) break;
+        if (std::find(candidates.begin(), candidates.end(), searchWords[guess.guessIdx]) != candidates.end()) return guess.guessIdx;
+    }
+    return ranked[0].guessIdx;
+}
+
+bool buildStrategyTree(Solver& solver, ScoringMetric metric, const std::string& path, StrategyTreeStats& stats, std::string& error) {
+    const std::vector<std::string>& searchWords = solver.getSearchWords();
+    const std::vector<std::string>& answerWords = solver.getAnswerWords();
+
+    std::unordered_map<std::string, int> searchIndex;
+    for (int i = 0; i < searchWords.size(); i++) {
+        searchIndex.emplace(searchWords[i], i);
+    }
+
+    //breadth first, so the nodes are written in the order they are built and the top levels share pages
+    std::vector<BuildNode> nodes(1);
+    std::vector<std::vector<int>> nodeAnswers(1);
+    for (int i = 0; i < answerWords.size(); i++) nodeAnswers[0].push_back(i);
+
+    int64_t guessSum = 0;
+    int worstGuesses = 0;
+    std::vector<std::vector<int>> buckets(FEEDBACK_CODE_COUNT);
+    for (size_t n = 0; n < nodes.size(); n++) {
+        std::vector<int> answerIdxs = std::move(nodeAnswers[n]);
+        if (answerIdxs.empty()) continue;
+
+        int guessIdx = pickGuess(solver, searchIndex, answerIdxs, metric);
+        for (int attempt = 0; guessIdx >= 0; attempt++) {
+            for (std::vector<int>& bucket : buckets) bucket.clear();
+            for (int answerIdx : answerIdxs) {
+                buckets[computeFeedbackCode(answerWords[answerIdx].c_str(), searchWords[guessIdx].c_str())].push_back(answerIdx);
+            }
+
+            //a guess that leaves every answer in one unsolved bucket would never end, guess a candidate instead
+            bool progress = buckets[SOLVED_FEEDBACK_CODE].size() > 0 || std::none_of(buckets.begin(), buckets.end(),
+                [&](const std::vector<int>& bucket) { return bucket.size() == answerIdxs.size(); });
+            if (progress) break;
+
+            auto found = searchIndex.find(answerWords[answerIdxs[0]]);
+            guessIdx = (attempt == 0 && found != searchIndex.end()) ? found->second : -1;
+        }
+        if (guessIdx < 0) {
+            error = "no guess separates the answers left after " + std::to_string(nodes[n].depth - 1) + " guesses";
+            return false;
+        }
+        nodes[n].guessIdx = guessIdx;
+
+        int depth = nodes[n].depth;
+        if (!buckets[SOLVED_FEEDBACK_CODE].empty()) {
+            guessSum += depth;
+            worstGuesses = std::max(worstGuesses, depth);
+        }
+        for (int code = 0; code < FEEDBACK_CODE_COUNT; code++) {
+            if (code == SOLVED_FEEDBACK_CODE || buckets[code].empty()) continue;
+
+            nodes[n].codes.push_back((unsigned char)code);
+            nodes[n].children.push_back((int)nodes.size());
+
+            BuildNode child;
+            child.depth = depth + 1;
+            nodes.push_back(std::move(child));
+            nodeAnswers.push_back(std::move(buckets[code]));
+        }
+    }
+
+    //node offsets, the tree is addressed with 32 bits
+    std::vector<uint32_t> offsets(nodes.size());
+    uint64_t fileSize = sizeof(StrategyTreeHeader);
+    for (size_t n = 0; n < nodes.size(); n++) {
+        offsets[n] = (uint32_t)fileSize;
+        fileSize += nodeBytes(nodes[n]);
+    }
+    if (fileSize > UINT32_MAX) {
+        error = "strategy tree is larger than 4GB";
+        return false;
+    }
+
+    std::vector<unsigned char> image((size_t)fileSize, 0);
+    StrategyTreeHeader& header = *((StrategyTreeHeader*)image.data());
+    std::memcpy(header.magic, strategyTreeMagic, sizeof(strategyTreeMagic));
+    header.version = STRATEGY_TREE_VERSION;
+    header.guessCount = (uint32_t)searchWords.size();
+    header.answerCount = (uint32_t)answerWords.size();
+    header.nodeCount = (uint32_t)nodes.size();
+    header.headerSize = sizeof(StrategyTreeHeader);
+    header.rootOffset = offsets[0];
+    header.listHash = hashWordLists(searchWords, answerWords);
+    header.averageGuesses = answerWords.empty() ? 0.0f : (float)guessSum / (float)answerWords.size();
+    header.worstGuesses = (uint32_t)worstGuesses;
+    header.tableSize = (uint32_t)(fileSize - sizeof(StrategyTreeHeader));
+
+    for (size_t n = 0; n < nodes.size(); n++) {
+        uint32_t* record = (uint32_t*)&image[offsets[n]];
+        uint32_t childCount = (uint32_t)nodes[n].children.size();
+        record[0] = (uint32_t)nodes[n].guessIdx;
+        record[1] = childCount;
+        for (uint32_t c = 0; c < childCount; c++) {
+            record[2 + c] = offsets[nodes[n].children[c]];
+        }
+        std::memcpy(&record[2 + childCount], nodes[n].codes.data(), childCount);
+    }
+
+    //write under a per process name and rename so nothing ever maps a half written tree
+#ifdef _WIN32
+    std::string tempPath = path + ".tmp" + std::to_string(_getpid());
+#else
+    std::string tempPath = path + ".tmp" + std::to_string(getpid());
+#endif
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        out.write((const char*)image.data(), image.size());
+        if (!out) {
+            out.close();
+            std::error_code ec;
+            std::filesystem::remove(tempPath, ec);
+            error = "could not write " + tempPath;
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+        error = "could not replace " + path;
+        return false;
+    }
+
+    stats.nodes = nodes.size();
+    stats.averageGuesses = header.averageGuesses;
+    stats.worstGuesses = worstGuesses;
+    return true;
+}
+
+StrategyTree::~StrategyTree() {
+    this->unmap();
+}
+
+void StrategyTree::unmap() {
+#ifdef _WIN32
+    if (this->mappedView != nullptr) UnmapViewOfFile(this->mappedView);
+    if (this->mappingHandle != nullptr) CloseHandle(this->mappingHandle);
+    if (this->fileHandle != nullptr) CloseHandle(this->fileHandle);
+    this->mappingHandle = nullptr;
+    this->fileHandle = nullptr;
+#else
+    if (this->mappedView != nullptr) munmap((void*)this->mappedView, this->mappedSize);
+#endif
+    this->mappedView = nullptr;
+    this->mappedSize = 0;
+}
+
+bool StrategyTree::open(const std::string& path, const std::vector<std::string>& guesses, const std::vector<std::string>& answers) {
+    this->unmap();
+
+    size_t fileSize = 0;
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart < (LONGLONG)sizeof(StrategyTreeHeader)) {
+        CloseHandle(file);
+        return false;
+    }
+    fileSize = (size_t)size.QuadPart;
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        return false;
+    }
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    this->fileHandle = file;
+    this->mappingHandle = mapping;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(StrategyTreeHeader)) {
+        close(fd);
+        return false;
+    }
+    fileSize = (size_t)st.st_size;
+
+    void* view = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); //the mapping keeps the file alive
+    if (view == MAP_FAILED) return false;
+#endif
+    this->mappedView = view;
+    this->mappedSize = fileSize;
+
+    //validate before trusting any of it
+    const StrategyTreeHeader& header = this->header();
+    if (std::memcmp(header.magic, strategyTreeMagic, sizeof(strategyTreeMagic)) != 0 ||
+        header.version != STRATEGY_TREE_VERSION ||
+        header.headerSize != sizeof(StrategyTreeHeader) ||
+        header.guessCount != guesses.size() ||
+        header.answerCount != answers.size() ||
+        header.listHash != hashWordLists(guesses, answers) ||
+        header.rootOffset != sizeof(StrategyTreeHeader) ||
+        fileSize > UINT32_MAX ||
+        fileSize != (size_t)header.headerSize + header.tableSize ||
+        !this->validNodes()
+    ) {
+        this->unmap();
+        return false;
+    }
+
+    return true;
+}
+
+bool StrategyTree::validNodes() const {
+    const StrategyTreeHeader& header = this->header();
+    const uint32_t end = (uint32_t)this->mappedSize;
+    if (header.nodeCount == 0) return false;
+
+    //the nodes are back to back, so walking them finds every offset a child may point at
+    std::vector<uint32_t> nodeOffsets;
+    nodeOffsets.reserve(header.nodeCount);
+    for (uint32_t node = header.rootOffset; node != end;) {
+        if (end - node < 8 || nodeOffsets.size() == header.nodeCount) return false;
+
+        const uint32_t* record = this->words(node);
+        uint32_t childCount = record[1];
+        if (record[0] >= header.guessCount || childCount >= FEEDBACK_CODE_COUNT) return false;
+
+        uint32_t bytes = 8 + 4 * childCount + ((childCount + 3) & ~3u);
+        if (end - node < bytes) return false;
+
+        //ascending codes for child's search, no child for solved
+        const unsigned char* codes = (const unsigned char*)&record[2 + childCount];
+        for (uint32_t c = 0; c < childCount; c++) {
+            if (codes[c] >= SOLVED_FEEDBACK_CODE || (c > 0 && codes[c] <= codes[c - 1])) return false;
+        }
+
+        nodeOffsets.push_back(node);
+        node += bytes;
+    }
+    if (nodeOffsets.size() != header.nodeCount) return false;
+
+    //children come after their parent, so following them always ends
+    for (uint32_t node : nodeOffsets) {
+        const uint32_t* record = this->words(node);
+        for (uint32_t c = 0; c < record[1]; c++) {
+            uint32_t childOffset = record[2 + c];
+            if (childOffset <= node || !std::binary_search(nodeOffsets.begin(), nodeOffsets.end(), childOffset)) return false;
+        }
+    }
+    return true;
+}
+
+uint32_t StrategyTree::child(uint32_t node, unsigned char code) const {
+    const uint32_t* record = this->words(node);
+    uint32_t childCount = record[1];
+    const uint32_t* offsets = &record[2];
+    const unsigned char* codes = (const unsigned char*)&offsets[childCount];
+
+    const unsigned char* found = std::lower_bound(codes, codes + childCount, code);
+    if (found == codes + childCount || *found != code) return 0;
+    return offsets[found - codes];
+}
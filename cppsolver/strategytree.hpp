@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "feedbackpattern.hpp"
+#include "scoringmetrics.hpp"
+
+class Solver;
+
+//2: feedback codes follow Wordle's repeated letter rule
+//3: node table size in the header, open checks every node
+constexpr uint32_t STRATEGY_TREE_VERSION = 3;
+
+//on disk layout, followed by the nodes back to back, root first
+//node: uint32 guess index, uint32 child count, then child count uint32 child offsets (from the start of the file)
+//and child count feedback codes ascending, padded to 4 bytes
+//solved and impossible codes have no child, so a turn is a search over a node's codes and one hop
+struct StrategyTreeHeader {
+    char magic[8]; // "WSSTRTRE"
+    uint32_t version;
+    uint32_t guessCount;
+    uint32_t answerCount;
+    uint32_t nodeCount;
+    uint32_t headerSize;
+    uint32_t rootOffset;
+    uint64_t listHash;    //hashWordLists of the lists the tree was built from
+    float averageGuesses; //over every answer, counting the solving guess
+    uint32_t worstGuesses;
+    uint32_t tableSize;   //bytes of nodes after the header, the rest of the file
+    char padding[12];
+};
+static_assert(sizeof(StrategyTreeHeader) == 64, "strategy tree header must stay 64 bytes");
+
+struct StrategyTreeStats {
+    size_t nodes = 0;
+    float averageGuesses = 0.0f;
+    int worstGuesses = 0;
+};
+
+//plays every answer word at once: each node guesses the solver's best guess by metric for the answers
+//still possible there (a candidate on ties), and gets a child for every feedback that leaves some
+//each node's ranking runs on the solver's pool
+//false with a reason in error if the file can't be written
+bool buildStrategyTree(Solver& solver, ScoringMetric metric, const std::string& path, StrategyTreeStats& stats, std::string& error);
+
+//read only strategy tree, memory mapped so every process on the host shares one copy
+//nodes are addressed by their file offset, 0 is no node
+class StrategyTree {
+public:
+    StrategyTree() = default;
+    ~StrategyTree();
+
+    StrategyTree(const StrategyTree&) = delete;
+    StrategyTree& operator=(const StrategyTree&) = delete;
+
+    //false if the file is missing, malformed or was built from other lists
+    //every node is checked once here (offsets, codes and guesses in range), so playing it needs no checks
+    bool open(const std::string& path, const std::vector<std::string>& guesses, const std::vector<std::string>& answers);
+
+    const StrategyTreeHeader& header() const { return *((const StrategyTreeHeader*)this->mappedView); }
+    uint32_t root() const { return this->header().rootOffset; }
+
+    //index into the search words
+    int guess(uint32_t node) const { return (int)this->words(node)[0]; }
+    //node after playing node's guess and getting code, 0 if the game is solved or the code can't happen
+    uint32_t child(uint32_t node, unsigned char code) const;
+
+private:
+    const uint32_t* words(uint32_t node) const { return (const uint32_t*)((const unsigned char*)this->mappedView + node); }
+    void unmap();
+    //walks the node table, true if it holds header().nodeCount well formed nodes and nothing else
+    bool validNodes() const;
+
+    const void* mappedView = nullptr;
+    size_t mappedSize = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+};
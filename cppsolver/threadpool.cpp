@@ -1,22 +1,39 @@
 #include "threadpool.h"
+#include "numatopology.hpp"
 #include "words.h"
 #include <iostream>
+#include <algorithm>
+
+static thread_local int currentWorkerIndex = -1;
 
 ThreadPool::ThreadPool(int threads)
 {
     this->terminate = false;
+    this->jobsPending = 0;
+
+    //storage has to exist before the threads can read it
+    this->threadLocalStorage.reserve(threads);
+    this->threadLocalStorage.resize(threads);
+
+    //contiguous blocks of workers per node
+    int nodes = numaNodeCount();
+    this->threadNode.resize(threads);
+    for (int i = 0; i < threads; i++) {
+        this->threadNode[i] = (i * nodes) / threads;
+    }
 
     for (int i = 0; i < threads; i++) {
         this->pool.emplace_back(&ThreadPool::ThreadLoop, this, i);
     }
-    this->threadLocalStorage.reserve(threads);
-    this->threadLocalStorage.resize(threads);
 }
 ThreadPool::~ThreadPool()
 {
     WaitCompletion();
-    this->terminate = true;
 
+    {
+        std::unique_lock<std::mutex> lock(queuelock);
+        this->terminate = true;
+    }
     this->dispatch.notify_all();
 
     for (int i = 0; i < this->pool.size(); i++) {
@@ -29,69 +46,111 @@ int ThreadPool::getThreadCount()
     return this->pool.size();
 }
 
-void ThreadPool::QueueTask(const JobRecipe task)
+int ThreadPool::currentThreadIndex()
 {
-    {
-        std::unique_lock<std::mutex> lock(queuelock);
-        jobsAssigned++;
-        jobs.push(task);
-    }
+    return currentWorkerIndex;
+}
 
-    dispatch.notify_one();
+void ThreadPool::QueueTask(const JobRecipe task)
+{
+    QueueBatchTask(&task, 1);
 }
 void ThreadPool::QueueBatchTask(const JobRecipe* tasks, int num)
 {
+    if (num <= 0) return;
+
+    std::shared_ptr<JobBatch> batch = std::make_shared<JobBatch>();
+    batch->jobs.assign(tasks, tasks + num);
+
     {
         std::unique_lock<std::mutex> lock(queuelock);
-        jobsAssigned += num;
-        for (int i = 0; i < num; i++) {
-            jobs.push(tasks[i]);
-        }
+        jobsPending += num;
+        batches.push_back(std::move(batch));
     }
 
-    dispatch.notify_all();
+    if (num == 1) dispatch.notify_one();
+    else dispatch.notify_all();
 }
 
 bool ThreadPool::isBusy()
 {
-    std::unique_lock<std::mutex> lock(queuelock);
-    return !jobs.empty();
+    return jobsPending.load() != 0;
 }
 
 void ThreadPool::WaitCompletion()
 {
     std::unique_lock<std::mutex> lock(queuelock);
-    this->jobsEmpty.wait(lock, [this] { return jobs.empty(); });
+    //the last worker to finish takes the lock before notifying, so this can't miss the wakeup
+    this->jobsEmpty.wait(lock, [this] { return jobsPending.load() == 0; });
 }
+
+void ThreadPool::RunBatch(JobBatch& batch, int threadIndex)
+{
+    const size_t total = batch.jobs.size();
+    const size_t threads = this->pool.size();
+
+    while (true) {
+        //guided chunking: big chunks while there is lots left, single jobs near the end for balance
+        size_t claimed = batch.cursor.load(std::memory_order_relaxed);
+        if (claimed >= total) return;
+        size_t chunk = std::max<size_t>(1, (total - claimed) / (threads * 4));
+
+        size_t begin = batch.cursor.fetch_add(chunk, std::memory_order_relaxed);
+        if (begin >= total) return;
+        size_t end = std::min(begin + chunk, total);
+
+        for (size_t i = begin; i < end; i++) {
+            batch.jobs[i].callback(batch.jobs[i].Parameter, this->threadLocalStorage[threadIndex]);
+        }
+
+        if (jobsPending.fetch_sub(end - begin) == (long long)(end - begin)) {
+            std::unique_lock<std::mutex> lock(queuelock);
+            jobsEmpty.notify_all();
+        }
+    }
+}
+
 void ThreadPool::ThreadLoop(int threadIndex)
 {
+    currentWorkerIndex = threadIndex;
+
+    if (numaNodeCount() > 1) {
+        pinCurrentThreadToNumaNode(this->threadNode[threadIndex]);
+    }
+
     while (true)
     {
-        JobRecipe task;
+        std::shared_ptr<JobBatch> batch;
 
         {
             std::unique_lock<std::mutex> lock(queuelock);
-            if (jobs.empty() && (jobsAssigned == jobsCompleted)) {
-                jobsEmpty.notify_all();
-            }
+            dispatch.wait(lock, [this] { return !batches.empty() || terminate; });
+            if (batches.empty()) return; //terminate
 
-            dispatch.wait(lock, [this] { return !jobs.empty() || terminate; });
-            if (terminate) return;
-
-            task = jobs.front();
-            jobs.pop();
+            batch = batches.front();
         }
 
-        task.callback(task.Parameter, this->threadLocalStorage[threadIndex]);
-        jobsCompleted++;
+        RunBatch(*batch, threadIndex);
 
+        //everything in the batch is claimed, stop handing it out
+        {
+            std::unique_lock<std::mutex> lock(queuelock);
+            if (!batches.empty() && batches.front() == batch) batches.pop_front();
+        }
     }
 }
 
-void ThreadPool::allocateThreadLocalStorage(const void* mem, size_t size, size_t alloc_alignment)
+std::shared_ptr<const CandidateArena> ThreadPool::allocateSharedStorage(const void* mem, size_t size, bool hugePages)
+{
+    std::shared_ptr<const CandidateArena> arena = CandidateArena::create(mem, size, hugePages);
+    setSharedStorage(arena);
+    return arena;
+}
+
+void ThreadPool::setSharedStorage(std::shared_ptr<const CandidateArena> arena)
 {
     for (int i = 0; i < this->pool.size(); i++) {
-        this->threadLocalStorage[i] = _aligned_malloc(size, alloc_alignment);
-        std::memcpy(this->threadLocalStorage[i], mem, size);
+        this->threadLocalStorage[i] = (arena == nullptr) ? nullptr : const_cast<void*>(arena->nodeCopy(this->threadNode[i]));
     }
-}
\ No newline at end of file
+    this->sharedStorage = std::move(arena);
+}
@@ -2,11 +2,14 @@
 #include <functional>
 #include <mutex>
 #include <vector>
-#include <queue>
+#include <deque>
+#include <memory>
 #include <thread>
 #include <condition_variable>
 #include <atomic>
 
+#include "candidatearena.hpp"
+
 struct JobRecipe {
     void* Parameter;
     void (*callback)(void* param, void* threadlocalstorage);
@@ -22,27 +25,41 @@ public:
     ~ThreadPool();
 
     int getThreadCount();
+    //index of the pool worker running the calling thread, -1 outside the pool
+    static int currentThreadIndex();
 
     void QueueTask(const JobRecipe task);
     void QueueBatchTask(const JobRecipe* tasks, int num);
     void WaitCompletion();
     bool isBusy();
 
-    void allocateThreadLocalStorage(const void* mem, size_t size, size_t alloc_alignment); //copies across all threads
+    //one shared copy per numa node, each worker gets its node's copy as threadlocalstorage
+    //only call while the pool is idle, the previous arena is released once nothing else holds it
+    std::shared_ptr<const CandidateArena> allocateSharedStorage(const void* mem, size_t size, bool hugePages = false);
+    void setSharedStorage(std::shared_ptr<const CandidateArena> arena);
 private:
+    //jobs from one QueueBatchTask call
+    //workers claim chunks of it with the cursor, the lock is only taken once per batch
+    struct JobBatch {
+        std::vector<JobRecipe> jobs;
+        std::atomic<size_t> cursor{ 0 };
+    };
+
     void ThreadLoop(int threadIndex);
+    void RunBatch(JobBatch& batch, int threadIndex);
 
-    bool terminate;
-    std::atomic<int> jobsCompleted;
-    std::atomic<int> jobsAssigned;
+    bool terminate; //guarded by queuelock
+    std::atomic<long long> jobsPending; //queued but not finished yet
 
     std::vector<std::thread> pool;
     std::vector<void*> threadLocalStorage;
+    std::vector<int> threadNode; //workers are pinned to this node when there is more than one
+    std::shared_ptr<const CandidateArena> sharedStorage;
 
     std::condition_variable dispatch;
 
     std::mutex queuelock;
-    std::queue<JobRecipe> jobs; //optimize with a lockless queue later maybe
+    std::deque<std::shared_ptr<JobBatch>> batches;
 
     std::condition_variable jobsEmpty;
-};
\ No newline at end of file
+};
@@ -0,0 +1,50 @@
+#include "topkbound.hpp"
+#include "words.h"
+
+#include <algorithm>
+#include <limits>
+
+TopKBound::TopKBound(int k, int workers) : k{ k }, heaps(workers), sharedBound{ std::numeric_limits<int64_t>::max() }
+{
+    for (WorkerHeap& heap : this->heaps) {
+        heap.entries.reserve(k + 1);
+    }
+}
+
+void TopKBound::offer(int worker, int64_t score, int guessIdx)
+{
+    if (this->k <= 0) return;
+
+    //pairs compare by score then index, the same order get_smallest_n_indexes uses
+    std::vector<std::pair<int64_t, int>>& entries = this->heaps[worker].entries;
+    std::pair<int64_t, int> entry{ score, guessIdx };
+    if (entries.size() == this->k) {
+        if (!(entry < entries.front())) return;
+        std::pop_heap(entries.begin(), entries.end());
+        entries.back() = entry;
+    }
+    else {
+        entries.push_back(entry);
+    }
+    std::push_heap(entries.begin(), entries.end());
+
+    if (entries.size() < this->k) return;
+
+    //lower the shared bound, other workers may be lowering it at the same time
+    int64_t kthBest = entries.front().first;
+    int64_t current = this->sharedBound.load(std::memory_order_relaxed);
+    while (kthBest < current && !this->sharedBound.compare_exchange_weak(current, kthBest, std::memory_order_relaxed)) {}
+}
+
+std::vector<std::pair<int64_t, int>> TopKBound::merge() const
+{
+    std::vector<std::pair<int64_t, int>> merged;
+    for (const WorkerHeap& heap : this->heaps) {
+        merged.insert(merged.end(), heap.entries.begin(), heap.entries.end());
+    }
+
+    size_t kept = std::min(merged.size(), (size_t)std::max(this->k, 0));
+    std::partial_sort(merged.begin(), merged.begin() + kept, merged.end());
+    merged.resize(kept);
+    return merged;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+// best k guesses by an integer score (lower is better, ties go to the lower guess index), collected from every pool worker
+// each worker keeps its own heap, the shared bound is the best k-th score any single worker has seen
+// a guess whose score can only end up above the bound is beaten by k others, so its job can stop early
+class TopKBound {
+public:
+    TopKBound(int k, int workers);
+
+    TopKBound(const TopKBound&) = delete;
+    TopKBound& operator=(const TopKBound&) = delete;
+
+    // scores only ever grow while a guess is evaluated, lowerBound is the least it can still end up at
+    bool canPrune(int64_t lowerBound) const { return lowerBound > this->sharedBound.load(std::memory_order_relaxed); }
+
+    // worker is the pool worker's index, only that worker touches its heap
+    void offer(int worker, int64_t score, int guessIdx);
+
+    // {score, guessIdx} best first, at most k, only call once every job is done
+    std::vector<std::pair<int64_t, int>> merge() const;
+
+private:
+    struct alignas(64) WorkerHeap {
+        std::vector<std::pair<int64_t, int>> entries; //max heap, the worst kept guess on top
+    };
+
+    int k;
+    std::vector<WorkerHeap> heaps;
+    alignas(64) std::atomic<int64_t> sharedBound;
+};
@@ -2,76 +2,323 @@
 #include "words.h"
 #include "findnocommonchars.hpp"
 
-WordFilter::WordFilter(const std::array<char, 5>& correct, const std::array<std::vector<char>, 5>& misplaced, const std::string& wrong) {
-    this->correct = correct;
-    this->misplaced = std::array<std::vector<char>, 5>{
-        misplaced[0], misplaced[1], misplaced[2], misplaced[3], misplaced[4]
-    };
-    this->wrong = std::vector<char>(wrong.cbegin(), wrong.cend());
+#include <algorithm>
+#include <cstring>
+
+static inline int constraintLetter(char c) {
+    return (c >= 'a' && c <= 'z') ? c - 'a' : -1;
 }
 
-WordFilter::WordFilter(const std::vector<WordFilter>& filters) {
-    this->correct = { ' ', ' ', ' ', ' ', ' ' };
-    this->misplaced = {};
-    this->wrong = {};
+template <int N>
+BasicFilterConstraints<N>::BasicFilterConstraints() {
+    this->green.fill(' ');
+    this->forbidden.fill(0);
+    this->minCount.fill(0);
+    this->maxCount.fill(N);
+    this->unsatisfiable = false;
+}
 
-    for (int i = 0; i < filters.size(); i++) {
-        for (int j = 0; j < 5; j++) {
-            //what???
-            if (filters[i].correct[j] != ' ') this->correct[j] = filters[i].correct[j];
+template <int N>
+BasicFilterConstraints<N>::BasicFilterConstraints(const BasicWordFilter<N>& filter) : BasicFilterConstraints() {
+    for (int j = 0; j < N; j++) {
+        char c = filter.correct[j];
+        if (c == ' ') continue;
+        if (constraintLetter(c) < 0) this->unsatisfiable = true;
+        else this->green[j] = c;
+    }
+    for (int j = 0; j < N; j++) {
+        for (char c : filter.misplaced[j]) {
+            int letter = constraintLetter(c);
+            if (letter < 0) {
+                this->unsatisfiable = true;
+                continue;
+            }
+            this->forbidden[j] |= 1u << letter;
+            this->minCount[letter] = std::max<uint8_t>(this->minCount[letter], 1);
+        }
+    }
+    for (char c : filter.wrong) {
+        int letter = constraintLetter(c);
+        if (letter >= 0) this->maxCount[letter] = 0;
+    }
+    for (int c = 0; c < letterCount; c++) {
+        this->minCount[c] = std::max(this->minCount[c], filter.minCount[c]);
+        this->maxCount[c] = std::min(this->maxCount[c], filter.maxCount[c]);
+    }
 
-            //should reserve maybe
-            this->misplaced[j].insert(this->misplaced[j].cend(), filters[i].misplaced[j].cbegin(), filters[i].misplaced[j].cend());
+    this->normalize();
+}
+
+template <int N>
+void BasicFilterConstraints<N>::merge(const BasicFilterConstraints& other) {
+    this->unsatisfiable |= other.unsatisfiable;
+    for (int j = 0; j < N; j++) {
+        if (other.green[j] != ' ') {
+            if (this->green[j] != ' ' && this->green[j] != other.green[j]) this->unsatisfiable = true;
+            this->green[j] = other.green[j];
         }
-        this->wrong.insert(this->wrong.cend(), filters[i].wrong.cbegin(), filters[i].wrong.cend());
+        this->forbidden[j] |= other.forbidden[j];
+    }
+    for (int c = 0; c < letterCount; c++) {
+        this->minCount[c] = std::max(this->minCount[c], other.minCount[c]);
+        this->maxCount[c] = std::min(this->maxCount[c], other.maxCount[c]);
     }
 
+    this->normalize();
 }
 
-WordFilter::WordFilter(const std::string& solution, const std::string& guess) {
-    this->correct = { ' ', ' ', ' ', ' ', ' ' };
-    this->misplaced = {};
-    this->wrong = {};
+template <int N>
+void BasicFilterConstraints<N>::normalize() {
+    const uint32_t allLetters = (1u << letterCount) - 1;
 
-    for (int i = 0; i < solution.size(); i++) {
-        if (solution[i] == guess[i]) {
-            this->correct[i] = guess[i];
+    int greenCount[letterCount] = {};
+    uint32_t freePositions = 0;
+    for (int j = 0; j < N && !this->unsatisfiable; j++) {
+        if (this->green[j] == ' ') {
+            freePositions |= 1u << j;
+            continue;
         }
-        else {
-            if (solution.find(guess[i]) != std::string::npos) {
-                this->misplaced[i].emplace_back(guess[i]);
-            }
-            else {
-                this->wrong.emplace_back(guess[i]);
+
+        //the green letter already rules every other letter out
+        int letter = this->green[j] - 'a';
+        if ((this->forbidden[j] >> letter) & 1) this->unsatisfiable = true;
+        this->forbidden[j] = 0;
+        greenCount[letter]++;
+    }
+
+    int totalMin = 0;
+    for (int c = 0; c < letterCount && !this->unsatisfiable; c++) {
+        this->minCount[c] = std::max<uint8_t>(this->minCount[c], (uint8_t)greenCount[c]);
+        if (this->minCount[c] > this->maxCount[c]) {
+            this->unsatisfiable = true;
+            break;
+        }
+        totalMin += this->minCount[c];
+
+        //a letter held to what the greens give can't go anywhere else: absent letters need no per position
+        //exclusions, and the rest become exclusions on every free position
+        if (this->maxCount[c] == greenCount[c]) {
+            for (int j = 0; j < N; j++) {
+                if (greenCount[c] == 0) this->forbidden[j] &= ~(1u << c);
+                else if ((freePositions >> j) & 1) this->forbidden[j] |= 1u << c;
             }
         }
     }
+    if (totalMin > N) this->unsatisfiable = true;
+
+    //a free position that can hold no letter at all
+    uint32_t absent = this->absentLetters();
+    for (int j = 0; j < N && !this->unsatisfiable; j++) {
+        if (((freePositions >> j) & 1) && ((this->forbidden[j] | absent) & allLetters) == allLetters) this->unsatisfiable = true;
+    }
+
+    //positions still open to each letter, a limit at or above that can never bind
+    for (int c = 0; c < letterCount && !this->unsatisfiable; c++) {
+        if (this->maxCount[c] == 0) continue;
+
+        int capacity = greenCount[c];
+        for (int j = 0; j < N; j++) {
+            if (((freePositions >> j) & 1) && !((this->forbidden[j] >> c) & 1)) capacity++;
+        }
+        if (this->minCount[c] > capacity) this->unsatisfiable = true;
+        if (this->maxCount[c] >= capacity) this->maxCount[c] = N;
+    }
+
+    if (this->unsatisfiable) {
+        *this = BasicFilterConstraints{};
+        this->unsatisfiable = true;
+    }
 }
 
-WordFilter::WordFilter(const char* solution, const char* guess) {
-    this->correct = { ' ', ' ', ' ', ' ', ' ' };
-    this->misplaced = {};
-    this->wrong = {};
+template <int N>
+uint32_t BasicFilterConstraints<N>::requiredLetters() const {
+    uint32_t greens = 0;
+    for (int j = 0; j < N; j++) {
+        if (this->green[j] != ' ') greens |= 1u << (this->green[j] - 'a');
+    }
+
+    uint32_t letters = 0;
+    for (int c = 0; c < letterCount; c++) {
+        if (!((greens >> c) & 1) && this->minCount[c] == 1 && this->maxCount[c] == N) letters |= 1u << c;
+    }
+    return letters;
+}
+
+template <int N>
+uint32_t BasicFilterConstraints<N>::absentLetters() const {
+    uint32_t letters = 0;
+    for (int c = 0; c < letterCount; c++) {
+        if (this->maxCount[c] == 0) letters |= 1u << c;
+    }
+    return letters;
+}
+
+template <int N>
+uint32_t BasicFilterConstraints<N>::countedLetters() const {
+    int greenCount[letterCount] = {};
+    for (int j = 0; j < N; j++) {
+        if (this->green[j] != ' ') greenCount[this->green[j] - 'a']++;
+    }
+
+    uint32_t letters = 0;
+    for (int c = 0; c < letterCount; c++) {
+        if (this->maxCount[c] == 0) continue;
+        bool required = greenCount[c] == 0 && this->minCount[c] == 1 && this->maxCount[c] == N;
+        if (!required && (this->minCount[c] > greenCount[c] || this->maxCount[c] < N)) letters |= 1u << c;
+    }
+    return letters;
+}
+
+//FNV-1a
+template <int N>
+uint64_t BasicFilterConstraints<N>::hash() const {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    auto mix = [&hash](const void* data, size_t size) {
+        const unsigned char* bytes = (const unsigned char*)data;
+        for (size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ULL;
+        }
+    };
+    mix(this->green.data(), N);
+    mix(this->forbidden.data(), N * sizeof(uint32_t));
+    mix(this->minCount.data(), letterCount);
+    mix(this->maxCount.data(), letterCount);
+    unsigned char never = this->unsatisfiable;
+    mix(&never, 1);
+    return hash;
+}
+
+template <int N>
+bool BasicFilterConstraints<N>::operator==(const BasicFilterConstraints& other) const {
+    return this->unsatisfiable == other.unsatisfiable && this->green == other.green && this->forbidden == other.forbidden
+        && this->minCount == other.minCount && this->maxCount == other.maxCount;
+}
+
+template <int N>
+BasicWordFilter<N>::BasicWordFilter(const std::array<char, N>& correct, const std::array<std::vector<char>, N>& misplaced, const std::string& wrong) : BasicWordFilter() {
+    this->correct = correct;
+    for (int j = 0; j < N; j++) {
+        for (char c : misplaced[j]) this->misplaced[j].push_back(c);
+    }
+    for (char c : wrong) this->wrong.push_back(c);
+}
+
+template <int N>
+BasicWordFilter<N>::BasicWordFilter(const std::vector<BasicWordFilter>& filters) : BasicWordFilter() {
+    for (int i = 0; i < filters.size(); i++) {
+        for (int j = 0; j < N; j++) {
+            //two different greens at one position leave no word, which a misplaced copy of the first says
+            char green = filters[i].correct[j];
+            if (green != ' ' && this->correct[j] != ' ' && this->correct[j] != green) this->misplaced[j].push_back(this->correct[j]);
+            else if (green != ' ') this->correct[j] = green;
+
+            this->misplaced[j].append(filters[i].misplaced[j]);
+        }
+        this->wrong.append(filters[i].wrong);
+
+        //a word has to satisfy every filter's limits
+        for (int c = 0; c < 26; c++) {
+            this->minCount[c] = std::max(this->minCount[c], filters[i].minCount[c]);
+            this->maxCount[c] = std::min(this->maxCount[c], filters[i].maxCount[c]);
+        }
+    }
 
-    for (int i = 0; i < 5; i++) {
-        if (solution[i] == guess[i]) {
+}
+
+template <int N>
+BasicWordFilter<N>::BasicWordFilter(const std::string& solution, const std::string& guess) : BasicWordFilter(solution.c_str(), guess.c_str()) {
+}
+
+template <int N>
+void BasicWordFilter<N>::feedbackStates(const char* solution, const char* guess, unsigned char* states) {
+    for (int i = 0; i < N; i++) states[i] = (solution[i] == guess[i]) ? 2 : 0;
+
+    for (int i = 0; i < N; i++) {
+        if (states[i] == 2) continue;
+
+        //copies of the letter off the greens, less the ones earlier positions already took
+        int unmatched = 0;
+        for (int j = 0; j < N; j++) {
+            if (states[j] != 2 && solution[j] == guess[i]) unmatched++;
+        }
+        for (int k = 0; k < i; k++) {
+            if (states[k] == 1 && guess[k] == guess[i]) unmatched--;
+        }
+        if (unmatched > 0) states[i] = 1;
+    }
+}
+
+template <int N>
+void BasicWordFilter<N>::applyFeedbackStates(const char* guess, const unsigned char* states) {
+    for (int i = 0; i < N; i++) {
+        if (states[i] == 2) {
             this->correct[i] = guess[i];
+            continue;
         }
-        else {
-            if (std::memchr(solution, guess[i], 5) != nullptr) {
-                this->misplaced[i].emplace_back(guess[i]);
-            }
-            else {
-                this->wrong.emplace_back(guess[i]);
-            }
+
+        //how many copies the feedback found, and whether it ran out of them
+        int found = 0;
+        bool exhausted = false;
+        for (int j = 0; j < N; j++) {
+            if (guess[j] != guess[i]) continue;
+            if (states[j] != 0) found++;
+            else exhausted = true;
         }
+
+        if (found == 0) {
+            this->wrong.emplace_back(guess[i]);
+            continue;
+        }
+
+        //somewhere, just not here, a wrong copy of a found letter says the same
+        this->misplaced[i].emplace_back(guess[i]);
+        int letter = constraintLetter(guess[i]);
+        if (letter < 0) continue;
+        this->minCount[letter] = std::max<uint8_t>(this->minCount[letter], (uint8_t)found);
+        if (exhausted) this->maxCount[letter] = (uint8_t)found;
+    }
+}
+
+template <int N>
+BasicWordFilter<N> BasicWordFilter<N>::fromFeedbackStates(const char* guess, const unsigned char* states) {
+    BasicWordFilter filter;
+    filter.applyFeedbackStates(guess, states);
+    return filter;
+}
+
+template <int N>
+BasicWordFilter<N>::BasicWordFilter(const char* solution, const char* guess) : BasicWordFilter() {
+    unsigned char states[N];
+    feedbackStates(solution, guess, states);
+    this->applyFeedbackStates(guess, states);
+}
+
+template <int N>
+LetterList BasicWordFilter<N>::limitedLetters() const {
+    LetterList letters;
+    for (int c = 0; c < 26; c++) {
+        if (this->minCount[c] > 1 || this->maxCount[c] < N) letters.push_back((char)('a' + c));
     }
+    return letters;
 }
 
-std::vector<std::string> WordFilter::filterWords(const std::vector<std::string>& wordlist)
+template <int N>
+bool BasicWordFilter<N>::letterCountsAllow(const char* word, const LetterList& limited) const {
+    for (char c : limited) {
+        int count = 0;
+        for (int j = 0; j < N; j++) count += (word[j] == c);
+        if (count < this->minCount[c - 'a'] || count > this->maxCount[c - 'a']) return false;
+    }
+    return true;
+}
+
+template <int N>
+std::vector<std::string> BasicWordFilter<N>::filterWords(const std::vector<std::string>& wordlist)
 {
     std::vector<std::string> filtered{};
     filtered.reserve(100); //micro-optimization
+    LetterList limited = this->limitedLetters();
 
     //Check each word in the given word list
     for (int i = 0; i < wordlist.size(); i++)
@@ -130,15 +377,19 @@ std::vector<std::string> WordFilter::filterWords(const std::vector<std::string>&
         //}
         if (!find_no_common_chars_sse42(word.c_str(), word.size(), this->wrong.data(), this->wrong.size())) continue;
 
+        if (!limited.empty() && !this->letterCountsAllow(word.c_str(), limited)) continue;
+
         filtered.emplace_back(word);
     }
 
     return filtered;
 }
 
-int WordFilter::filterWordsCount(const std::vector<std::string>& wordlist)
+template <int N>
+int BasicWordFilter<N>::filterWordsCount(const std::vector<std::string>& wordlist)
 {
     int count = 0;
+    LetterList limited = this->limitedLetters();
     //Check each word in the given word list
     for (int i = 0; i < wordlist.size(); i++)
     {
@@ -192,7 +443,9 @@ int WordFilter::filterWordsCount(const std::vector<std::string>& wordlist)
                 break;
             }
         }
-        
+        if (!possibleWord) continue;
+
+        if (!limited.empty() && !this->letterCountsAllow(word.c_str(), limited)) continue;
 
         count++;
     }
@@ -200,57 +453,105 @@ int WordFilter::filterWordsCount(const std::vector<std::string>& wordlist)
     return count;
 }
 
-int WordFilter::optimized_filterWordsCount(const unsigned char* wordlist, size_t words, int* scratchmem) {
+template <int N>
+int BasicWordFilter<N>::optimized_filterWordsCount(const unsigned char* wordlist, size_t words, int* scratchmem) {
     int count = 0;
 
     //create null terminated wrong letter list
+    //padded to 16 bytes past the end since the sse4.2 helpers load whole xmm registers
     size_t wrongletterlistsize = this->wrong.size();
-    char* wrongletterlist = new char[wrongletterlistsize + 1];
-    wrongletterlist[wrongletterlistsize] = 0;
+    char wrongletterlist[LetterList::capacity + 16] = {};
     std::memcpy(wrongletterlist, this->wrong.data(), wrongletterlistsize);
-    
-    //create packed misplace letter representation
-    size_t misplaceLettersLists_size = 0;
-    char misplaceLettersLists_sizes[5];
-    for (int i = 0; i < 5; i++) {
-        misplaceLettersLists_size += this->misplaced[i].size();
-        misplaceLettersLists_sizes[i] = this->misplaced[i].size();
-    }
-    char* misplaceLettersLists = nullptr;
-    if(misplaceLettersLists_size != 0)
-    {
-        misplaceLettersLists = new char[misplaceLettersLists_size];
-        size_t offsetsum = 0;
+    LetterList limited = this->limitedLetters();
+
+    if constexpr (N == 5) {
+        //create packed misplace letter representation
+        size_t misplaceLettersLists_size = 0;
+        char misplaceLettersLists_sizes[5];
+        char misplaceLettersLists[5 * LetterList::capacity];
         for (int i = 0; i < 5; i++) {
-            std::memcpy(&(misplaceLettersLists[offsetsum]), this->misplaced[i].data(), misplaceLettersLists_sizes[i]);
-            offsetsum += misplaceLettersLists_sizes[i];
+            misplaceLettersLists_sizes[i] = this->misplaced[i].size();
+            std::memcpy(&(misplaceLettersLists[misplaceLettersLists_size]), this->misplaced[i].data(), misplaceLettersLists_sizes[i]);
+            misplaceLettersLists_size += this->misplaced[i].size();
         }
-    }
-    
 
-    //Check each word in the given word list
-    for (int i = 0; i < words; i++)
-    {
-        const unsigned char* word = &(wordlist[i * 5]);
 
-        //Check if all the correct letters are present
-        if (!masked_greenletter_compare(this->correct.data(), word)) continue;
-        
-        //Check if all the misplaced letters are present
-        if ((misplaceLettersLists_size != 0) && !check_misplaced_letters(word, misplaceLettersLists, misplaceLettersLists_sizes)) continue;
+        //Check each word in the given word list
+        for (int i = 0; i < words; i++)
+        {
+            const unsigned char* word = &(wordlist[i * 5]);
 
-        if ((wrongletterlistsize > 16 ?
-            (!find_no_common_chars_sse42((const char*)word, 5, this->wrong.data(), wrongletterlistsize)) :
-            fast_find_no_common_chars_sse42((const char*)word, wrongletterlist)
-            )) continue;
+            //Check if all the correct letters are present
+            if (!masked_greenletter_compare(this->correct.data(), word)) continue;
 
-        count++;
+            //Check if all the misplaced letters are present
+            if ((misplaceLettersLists_size != 0) && !check_misplaced_letters(word, misplaceLettersLists, misplaceLettersLists_sizes)) continue;
+
+            if ((wrongletterlistsize > 16 ?
+                (!find_no_common_chars_sse42((const char*)word, 5, wrongletterlist, wrongletterlistsize)) :
+                fast_find_no_common_chars_sse42((const char*)word, wrongletterlist)
+                )) continue;
+
+            if (!limited.empty() && !this->letterCountsAllow((const char*)word, limited)) continue;
+
+            count++;
+        }
     }
+    else {
+        //the nasm green and misplaced helpers are written for 5 letters, other lengths check those in c++
+        for (int i = 0; i < words; i++)
+        {
+            const char* word = (const char*)&(wordlist[i * N]);
+
+            bool possibleWord = true;
+            unrolledFor<N>([&](auto j) {
+                if (this->correct[j] != ' ' && this->correct[j] != word[j]) possibleWord = false;
+            });
+            if (!possibleWord) continue;
+
+            for (int j = 0; j < N && possibleWord; j++) {
+                for (char c : this->misplaced[j]) {
+                    if (c == word[j] || std::memchr(word, c, N) == nullptr) {
+                        possibleWord = false;
+                        break;
+                    }
+                }
+            }
+            if (!possibleWord) continue;
+
+            if ((wrongletterlistsize != 0) && !find_no_common_chars_sse42(word, N, wrongletterlist, wrongletterlistsize)) continue;
 
-    delete[] wrongletterlist;
+            if (!limited.empty() && !this->letterCountsAllow(word, limited)) continue;
 
-    if(misplaceLettersLists != nullptr)
-        delete[] misplaceLettersLists;
+            count++;
+        }
+    }
 
     return count;
 }
+
+void hyperpackedAppendRows(const unsigned char* rows, size_t rowStride, int letters, size_t count, int packwidth, size_t outWords, unsigned char* out) {
+    if (count == 0) return;
+
+    //the words may straddle a batch boundary of out, the rest start the next batch
+    size_t lane = outWords % packwidth;
+    size_t first = std::min(count, packwidth - lane);
+    unsigned char* batch = &out[(outWords / packwidth) * letters * packwidth];
+    for (int j = 0; j < letters; j++) {
+        std::memcpy(&batch[j * packwidth + lane], &rows[j * rowStride], first);
+        if (first < count) {
+            std::memcpy(&batch[(letters + j) * packwidth], &rows[j * rowStride + first], count - first);
+        }
+    }
+}
+
+//the lengths the solver is built for, the intrinsic kernels instantiate the same ones
+template struct BasicFilterConstraints<4>;
+template struct BasicFilterConstraints<5>;
+template struct BasicFilterConstraints<6>;
+template struct BasicFilterConstraints<7>;
+
+template class BasicWordFilter<4>;
+template class BasicWordFilter<5>;
+template class BasicWordFilter<6>;
+template class BasicWordFilter<7>;
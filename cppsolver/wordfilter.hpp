@@ -3,114 +3,262 @@
 #include <vector>
 #include <string>
 #include <array>
+#include <utility>
+#include <type_traits>
+#include <cstdint>
 
 
-class WordFilter {
+// fixed capacity letter set stored inline, so building filters never touches the heap
+// letters are only stored once, which also bounds the size when filters are merged
+class LetterList {
+public:
+    static constexpr int capacity = 26;
+
+    void push_back(char c) {
+        if (this->contains(c) || this->count >= capacity) return;
+        this->letters[this->count++] = c;
+    }
+    void emplace_back(char c) { this->push_back(c); }
+    void append(const LetterList& other) {
+        for (char c : other) this->push_back(c);
+    }
+
+    bool contains(char c) const {
+        for (int i = 0; i < this->count; i++) {
+            if (this->letters[i] == c) return true;
+        }
+        return false;
+    }
+
+    size_t size() const { return this->count; }
+    bool empty() const { return this->count == 0; }
+    const char* data() const { return this->letters; }
+    char operator[](size_t i) const { return this->letters[i]; }
+    const char* begin() const { return this->letters; }
+    const char* end() const { return this->letters + this->count; }
+
+private:
+    char letters[capacity];
+    int count = 0;
+};
+
+// calls f(std::integral_constant<int, 0>) ... f(std::integral_constant<int, N - 1>)
+// the per letter loops in the kernels go through this so every word length gets a fully unrolled body
+template <typename F, int... I>
+inline void unrolledForImpl(F& f, std::integer_sequence<int, I...>) {
+    (f(std::integral_constant<int, I>{}), ...);
+}
+template <int N, typename F>
+inline void unrolledFor(F&& f) {
+    unrolledForImpl(f, std::make_integer_sequence<int, N>{});
+}
+
+template <int N>
+class BasicWordFilter;
+
+// normalized form of a filter, what the simd kernels and the word index read
+// letters are bits (c - 'a'), so merging, comparing and hashing forms is a fixed amount of work
+// constraints others already imply are dropped, so filters differing only in those (a misplaced letter named at
+// several positions, a wrong letter also excluded from a position, a letter the greens already supply) normalize
+// to the same form, and the kernels never compare a letter twice
+template <int N>
+struct BasicFilterConstraints {
+    static constexpr int letterCount = 26;
+
+    std::array<char, N> green;                      // letter each position must hold, ' ' if free
+    std::array<uint32_t, N> forbidden;              // letters a free position can't hold, 0 on green positions
+    std::array<uint8_t, letterCount> minCount;      // at least this many of each letter, the greens included
+    std::array<uint8_t, letterCount> maxCount;      // at most this many, N for no limit
+    bool unsatisfiable;                             // no word passes, every other field is as for no constraints
+
+    // keeps every word
+    BasicFilterConstraints();
+    // the same words as filter, letters outside a-z never match
+    explicit BasicFilterConstraints(const BasicWordFilter<N>& filter);
+
+    // keep only the words both kept, O(26)
+    void merge(const BasicFilterConstraints& other);
+
+    // most feedback only asks for a letter somewhere (minCount 1) or nowhere (maxCount 0), a repeated guess letter
+    // can also give a larger minimum or a maximum, which the kernels count per word
+    // letters a word has to hold more of than its green positions give it
+    uint32_t requiredLetters() const;
+    // letters a word can't hold at all
+    uint32_t absentLetters() const;
+    // letters with a count limit that is neither of those, the kernels count these per word
+    uint32_t countedLetters() const;
+
+    // FNV-1a over the form, equal forms hash equal
+    uint64_t hash() const;
+    bool operator==(const BasicFilterConstraints& other) const;
+    bool operator!=(const BasicFilterConstraints& other) const { return !(*this == other); }
+
+private:
+    void normalize();
+};
+
+using FilterConstraints = BasicFilterConstraints<5>;
+
+// filter for words of N letters
+// instantiated for 4 to 7 letters in wordfilter.cpp and the intrinsic kernel files
+template <int N>
+class BasicWordFilter {
 
 public:
-    
-    // Helper: Precompute broadcasted filter data (can be done in constructor or lazily)
-    struct SIMD_FilterData {
-        // For correct letters
-        std::array<__m256i, 5> ymm_correct_chars;
-        std::array<__m256i, 5> ymm_correct_is_space_mask; // 0xFF if correct[j] is ' ', 0x00 otherwise
+    static constexpr int wordLength = N;
 
-        // For misplaced letters
-        // For each position j, a vector of broadcasted misplaced chars
-        std::array<std::vector<__m256i>, 5> ymm_misplaced_chars_bcast;
+    // Helper: Precompute broadcasted filter data
+    // built from the normalized constraints, one broadcast per letter a check needs
+    // the hyperpacked kernels build one on their stack per call, so filters stay small values that copy cheaply
+    struct SIMD_FilterData {
+        // For correct letters, only the green positions
+        std::array<__m256i, N> ymm_correct_chars;
+        std::array<int, N> ymm_correct_positions;
+        int ymm_correct_count;
 
-        // For wrong letters
-        std::vector<__m256i> ymm_wrong_chars_bcast;
+        // For each position j, the broadcasted letters it can't hold (first ymm_forbidden_count[j] are valid)
+        std::array<std::array<__m256i, LetterList::capacity>, N> ymm_forbidden_chars_bcast;
+        std::array<int, N> ymm_forbidden_count;
 
-        __m256i ymm_all_ones;
+        // letters that must be somewhere in the word, checked once however many positions named them
+        std::array<__m256i, LetterList::capacity> ymm_required_chars_bcast;
+        int ymm_required_count;
 
-        SIMD_FilterData(const WordFilter& wf) {
-            ymm_all_ones = _mm256_set1_epi8(0xFF); // or _mm256_cmpeq_epi8(_mm256_setzero_si256(), _mm256_setzero_si256())
+        // For wrong letters
+        std::array<__m256i, LetterList::capacity> ymm_wrong_chars_bcast;
+        int ymm_wrong_count;
 
-            __m256i space_char_bcast = _mm256_set1_epi8(' ');
-            for (int j = 0; j < 5; ++j) {
-                ymm_correct_chars[j] = _mm256_set1_epi8(wf.correct[j]);
-                ymm_correct_is_space_mask[j] = _mm256_cmpeq_epi8(ymm_correct_chars[j], space_char_bcast);
-            }
+        // letters with other count limits, counted per word
+        std::array<__m256i, LetterList::capacity> ymm_counted_chars_bcast;
+        std::array<std::pair<int, int>, LetterList::capacity> counted_limits; // {min, max}
+        int ymm_counted_count;
 
-            for (int j = 0; j < 5; ++j) {
-                for (char m_char : wf.misplaced[j]) {
-                    ymm_misplaced_chars_bcast[j].push_back(_mm256_set1_epi8(m_char));
-                }
-            }
+        bool unsatisfiable;
+        __m256i ymm_all_ones;
 
-            for (char w_char : wf.wrong) {
-                ymm_wrong_chars_bcast.push_back(_mm256_set1_epi8(w_char));
-            }
-        }
-        SIMD_FilterData() = default;
+        // fills in place, the arrays are large enough that copying them around would cost more than building
+        // defined with the AVX2 kernel
+        void build(const BasicFilterConstraints<N>& constraints);
     };
 
     struct SIMD_FilterData_AVX512 {
-        std::array<__m512i, 5> zmm_correct_chars;
-        std::array<__mmask64, 5> k_correct_is_space; // Stores k-mask directly
-
-        std::array<std::vector<__m512i>, 5> zmm_misplaced_chars_bcast;
-        std::vector<__m512i> zmm_wrong_chars_bcast;
-        // No need for zmm_all_ones if we use k-mask operations mainly, but good for blend/xor
+        std::array<__m512i, N> zmm_correct_chars;
+        std::array<int, N> zmm_correct_positions;
+        int zmm_correct_count;
 
-        SIMD_FilterData_AVX512() = default;
+        std::array<std::array<__m512i, LetterList::capacity>, N> zmm_forbidden_chars_bcast;
+        std::array<int, N> zmm_forbidden_count;
+        std::array<__m512i, LetterList::capacity> zmm_required_chars_bcast;
+        int zmm_required_count;
+        std::array<__m512i, LetterList::capacity> zmm_wrong_chars_bcast;
+        int zmm_wrong_count;
+        std::array<__m512i, LetterList::capacity> zmm_counted_chars_bcast;
+        std::array<std::pair<int, int>, LetterList::capacity> counted_limits; // {min, max}
+        int zmm_counted_count;
 
-        SIMD_FilterData_AVX512(const WordFilter& wf) {
-            __m512i space_char_bcast = _mm512_set1_epi8(' ');
-            for (int j = 0; j < 5; ++j) {
-                zmm_correct_chars[j] = _mm512_set1_epi8(wf.correct[j]);
-                k_correct_is_space[j] = _mm512_cmpeq_epi8_mask(zmm_correct_chars[j], space_char_bcast);
-            }
-
-            for (int j = 0; j < 5; ++j) {
-                for (char m_char : wf.misplaced[j]) {
-                    zmm_misplaced_chars_bcast[j].push_back(_mm512_set1_epi8(m_char));
-                }
-            }
+        bool unsatisfiable;
 
-            for (char w_char : wf.wrong) {
-                zmm_wrong_chars_bcast.push_back(_mm512_set1_epi8(w_char));
-            }
-        }
+        // defined with the AVX-512 kernel
+        void build(const BasicFilterConstraints<N>& constraints);
     };
 
-    std::array<char, 5> correct;
-    std::array<std::vector<char>, 5> misplaced;
-    std::vector<char> wrong;
+    std::array<char, N> correct;
+    std::array<LetterList, N> misplaced;
+    LetterList wrong;
+    // limits on how many of a letter a word holds, indexed c - 'a', on top of the lists above (0 and N for none)
+    // a letter guessed more often than the answer holds it gets a maximum, one that came back correct or misplaced
+    // more than once gets a minimum
+    std::array<uint8_t, 26> minCount;
+    std::array<uint8_t, 26> maxCount;
 
-    WordFilter() : correct{ ' ', ' ', ' ', ' ', ' ' }, misplaced{} {};
+    BasicWordFilter() : misplaced{} {
+        this->correct.fill(' ');
+        this->minCount.fill(0);
+        this->maxCount.fill(N);
+    };
 
-    WordFilter(
-        const std::array<char, 5>& correct,
-        const std::array<std::vector<char>, 5>& misplaced,
+    BasicWordFilter(
+        const std::array<char, N>& correct,
+        const std::array<std::vector<char>, N>& misplaced,
         const std::string& wrong
     );
-    explicit WordFilter(
-        const std::vector<WordFilter>& filters
+    // the words every one of filters keeps
+    explicit BasicWordFilter(
+        const std::vector<BasicWordFilter>& filters
     );
     //after guess?
-    WordFilter(
+    BasicWordFilter(
         const std::string& solution, const std::string& guess
     );
-    WordFilter(
+    BasicWordFilter(
         const char* solution, const char* guess
     );
 
+    // the normalized form of this filter
+    BasicFilterConstraints<N> constraints() const { return BasicFilterConstraints<N>{ *this }; }
+
     std::vector<std::string> filterWords(const std::vector<std::string>& wordlist);
     int filterWordsCount(const std::vector<std::string>& wordlist);
+    // flat list, N bytes per word
     int optimized_filterWordsCount(const unsigned char* wordlist, size_t words, int* scratchmem);
 
-    bool simd_data_initialized = false;
-    SIMD_FilterData filter_simd_data;
-
-    SIMD_FilterData_AVX512 filter_simd_data_avx512; // Member instance
-    bool simd_data_avx512_initialized = false;
-
-    int hyperpacked_optimized_filterWordsCount(const unsigned char* hyperpacked_wordlist, size_t words);
+    // hyperpacked lists, N rows per batch (see hyperpackWordList<N>)
+    int hyperpacked_optimized_filterWordsCount(const unsigned char* hyperpacked_wordlist, size_t words) const;
     int hyperpacked_optimized_filterWordsCount_AVX512(
         const unsigned char* hyperpacked_wordlist,
         size_t words
-    );
+    ) const;
+
+    // writes the words of a hyperpacked list passing the filter to out as a new hyperpacked list at the same pack width
+    // (32 for the AVX2 kernel, 64 for AVX-512), zero padded, in list order, returns how many passed
+    // out must hold as many bytes as the input list, words never go back through std::string
+    size_t hyperpacked_filterCompact(const unsigned char* hyperpacked_wordlist, size_t words, unsigned char* out) const;
+    size_t hyperpacked_filterCompact_AVX512(const unsigned char* hyperpacked_wordlist, size_t words, unsigned char* out) const;
+
+    // solutions per call of the blocked kernels below
+    static constexpr int filterBlockSize = 64;
+
+    // per position 2 = correct, 1 = misplaced, 0 = wrong, the split the (solution, guess) constructor makes
+    // follows Wordle for repeated letters: greens first, then each other guess letter, left to right, is misplaced
+    // only while the solution has a copy of it nothing matched yet
+    static void feedbackStates(const char* solution, const char* guess, unsigned char* states);
+    // the filter the (solution, guess) constructor builds for a solution giving these states, when only the feedback is known
+    static BasicWordFilter fromFeedbackStates(const char* guess, const unsigned char* states);
+
+    // without a repeated letter the states only depend on which guess letters the solution holds
+    static bool hasRepeatedLetter(const char* guess) {
+        for (int i = 0; i < N; i++) {
+            for (int k = i + 1; k < N; k++) {
+                if (guess[k] == guess[i]) return true;
+            }
+        }
+        return false;
+    }
+
+    // counts[s] = BasicWordFilter{ solutions + s * N, guess }.hyperpacked_optimized_filterWordsCount(...)
+    // for up to filterBlockSize solutions, N bytes each
+    // every batch is loaded once for the whole block and the guess's letter compares are shared by every filter,
+    // so each extra filter only costs N mask ANDs and a popcount per batch
+    // guesses with a repeated letter can give count limits the shared masks can't express, those run
+    // hyperpacked_optimized_filterWordsCount once per solution instead
+    static void hyperpacked_blockFilterWordsCount(const char* guess, const char* solutions, int solutionCount, const unsigned char* hyperpacked_wordlist, size_t words, int* counts);
+    static void hyperpacked_blockFilterWordsCount_AVX512(const char* guess, const char* solutions, int solutionCount, const unsigned char* hyperpacked_wordlist, size_t words, int* counts);
+
+private:
+    // sets every field from feedback states, what the (solution, guess) constructors and fromFeedbackStates share
+    void applyFeedbackStates(const char* guess, const unsigned char* states);
+
+    // letters with a minCount or maxCount limit, the scalar filters count these per word
+    LetterList limitedLetters() const;
+    bool letterCountsAllow(const char* word, const LetterList& limited) const;
 };
 
+using WordFilter = BasicWordFilter<5>;
+
+// copies the bytes of src whose bit is set in mask to dst, in order, returns how many
+// reads lanes bytes (a multiple of 8) of src, dst needs 8 bytes of slack past the result
+// shuffle table version, defined with the AVX2 kernels
+size_t compactBytesByMask(const unsigned char* src, uint64_t mask, int lanes, unsigned char* dst);
+
+// appends count words, given as rows of compacted letters rowStride bytes apart, to the hyperpacked list out holding outWords words
+void hyperpackedAppendRows(const unsigned char* rows, size_t rowStride, int letters, size_t count, int packwidth, size_t outWords, unsigned char* out);
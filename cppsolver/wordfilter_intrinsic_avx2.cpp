@@ -1,108 +1,337 @@
 #include "wordfilter.hpp"
 #include "words.h"
 
-int WordFilter::hyperpacked_optimized_filterWordsCount(
+#include <algorithm>
+#include <cstring>
+
+template <int N>
+void BasicWordFilter<N>::SIMD_FilterData::build(const BasicFilterConstraints<N>& constraints) {
+    ymm_all_ones = _mm256_set1_epi8(0xFF); // or _mm256_cmpeq_epi8(_mm256_setzero_si256(), _mm256_setzero_si256())
+    unsatisfiable = constraints.unsatisfiable;
+
+    ymm_correct_count = 0;
+    for (int j = 0; j < N; ++j) {
+        if (constraints.green[j] == ' ') continue;
+        ymm_correct_positions[ymm_correct_count] = j;
+        ymm_correct_chars[ymm_correct_count++] = _mm256_set1_epi8(constraints.green[j]);
+    }
+
+    for (int j = 0; j < N; ++j) {
+        ymm_forbidden_count[j] = 0;
+        for (int c = 0; c < BasicFilterConstraints<N>::letterCount; ++c) {
+            if ((constraints.forbidden[j] >> c) & 1) {
+                ymm_forbidden_chars_bcast[j][ymm_forbidden_count[j]++] = _mm256_set1_epi8('a' + c);
+            }
+        }
+    }
+
+    uint32_t required = constraints.requiredLetters();
+    uint32_t absent = constraints.absentLetters();
+    uint32_t counted = constraints.countedLetters();
+    ymm_required_count = 0;
+    ymm_wrong_count = 0;
+    ymm_counted_count = 0;
+    for (int c = 0; c < BasicFilterConstraints<N>::letterCount; ++c) {
+        __m256i letter_bcast = _mm256_set1_epi8('a' + c);
+        if ((required >> c) & 1) ymm_required_chars_bcast[ymm_required_count++] = letter_bcast;
+        if ((absent >> c) & 1) ymm_wrong_chars_bcast[ymm_wrong_count++] = letter_bcast;
+        if ((counted >> c) & 1) {
+            counted_limits[ymm_counted_count] = { constraints.minCount[c], constraints.maxCount[c] };
+            ymm_counted_chars_bcast[ymm_counted_count++] = letter_bcast;
+        }
+    }
+}
+
+// steps 2-4 of the hyperpacked kernels, the lanes of one loaded batch that pass every constraint
+// padding lanes are not masked off here
+template <int N>
+static inline unsigned int filterBatchLanes(const typename BasicWordFilter<N>::SIMD_FilterData& filter_simd_data, const std::array<__m256i, N>& ymm_word_char_cols) {
+    if (filter_simd_data.unsatisfiable) return 0;
+    __m256i ymm_batch_pass_mask = filter_simd_data.ymm_all_ones;
+
+    // 2. Correct Letters, free positions have nothing to compare
+    for (int g = 0; g < filter_simd_data.ymm_correct_count; ++g) {
+        __m256i char_match = _mm256_cmpeq_epi8(ymm_word_char_cols[filter_simd_data.ymm_correct_positions[g]], filter_simd_data.ymm_correct_chars[g]);
+        ymm_batch_pass_mask = _mm256_and_si256(ymm_batch_pass_mask, char_match);
+    }
+
+    // OPTIMIZATION: Early exit if all words in batch failed
+    // _mm256_testz_si256(a, b) returns 1 if (a & b) is all zeros.
+    // We want to check if ymm_batch_pass_mask itself is all zeros.
+    // A common way: test ymm_batch_pass_mask against itself. If it's zero, (mask & mask) is zero.
+    // Or, more directly, compare its movemask to 0.
+    if (_mm256_movemask_epi8(ymm_batch_pass_mask) == 0) {
+        return 0;
+    }
+
+    // 3. Misplaced Letters: the letters each position can't hold, one compare each
+    for (int j = 0; j < N; ++j) {
+        if (filter_simd_data.ymm_forbidden_count[j] == 0) continue;
+
+        __m256i ymm_forbidden_at_j = _mm256_setzero_si256();
+        for (int m = 0; m < filter_simd_data.ymm_forbidden_count[j]; ++m) {
+            __m256i ymm_eq_at_j = _mm256_cmpeq_epi8(ymm_word_char_cols[j], filter_simd_data.ymm_forbidden_chars_bcast[j][m]);
+            ymm_forbidden_at_j = _mm256_or_si256(ymm_forbidden_at_j, ymm_eq_at_j);
+        }
+        ymm_batch_pass_mask = _mm256_andnot_si256(ymm_forbidden_at_j, ymm_batch_pass_mask);
+    }
+
+    // then every letter that must be somewhere, once
+    for (int m = 0; m < filter_simd_data.ymm_required_count; ++m) {
+        const __m256i& ymm_m_bcast = filter_simd_data.ymm_required_chars_bcast[m];
+        __m256i ymm_present_in_word = _mm256_setzero_si256();
+        unrolledFor<N>([&](auto k) {
+            __m256i ymm_eq_at_k = _mm256_cmpeq_epi8(ymm_word_char_cols[k], ymm_m_bcast);
+            ymm_present_in_word = _mm256_or_si256(ymm_present_in_word, ymm_eq_at_k);
+        });
+        ymm_batch_pass_mask = _mm256_and_si256(ymm_batch_pass_mask, ymm_present_in_word);
+    }
+
+    // OPTIMIZATION: Early exit after the misplaced letters
+    if (_mm256_movemask_epi8(ymm_batch_pass_mask) == 0) {
+        return 0;
+    }
+
+    // 4. Wrong Letters (same logic as before)
+    for (int w = 0; w < filter_simd_data.ymm_wrong_count; ++w) {
+        const __m256i& ymm_w_bcast = filter_simd_data.ymm_wrong_chars_bcast[w];
+        __m256i ymm_is_w_in_word = _mm256_setzero_si256();
+        unrolledFor<N>([&](auto k) {
+            __m256i ymm_eq_at_k = _mm256_cmpeq_epi8(ymm_word_char_cols[k], ymm_w_bcast);
+            ymm_is_w_in_word = _mm256_or_si256(ymm_is_w_in_word, ymm_eq_at_k);
+        });
+        __m256i ymm_not_w_in_word = _mm256_xor_si256(ymm_is_w_in_word, filter_simd_data.ymm_all_ones);
+        ymm_batch_pass_mask = _mm256_and_si256(ymm_batch_pass_mask, ymm_not_w_in_word);
+
+        // OPTIMIZATION: Early exit after checking each wrong letter
+        if (_mm256_movemask_epi8(ymm_batch_pass_mask) == 0) {
+            return 0;
+        }
+    }
+
+    // 5. Letter counts, cmpeq lanes are -1 so subtracting them counts up
+    // counts never exceed N, so the signed compares are safe
+    for (int l = 0; l < filter_simd_data.ymm_counted_count; ++l) {
+        const __m256i& ymm_l_bcast = filter_simd_data.ymm_counted_chars_bcast[l];
+        __m256i ymm_count = _mm256_setzero_si256();
+        unrolledFor<N>([&](auto k) {
+            ymm_count = _mm256_sub_epi8(ymm_count, _mm256_cmpeq_epi8(ymm_word_char_cols[k], ymm_l_bcast));
+        });
+        __m256i ymm_too_few = _mm256_cmpgt_epi8(_mm256_set1_epi8((char)filter_simd_data.counted_limits[l].first), ymm_count);
+        __m256i ymm_too_many = _mm256_cmpgt_epi8(ymm_count, _mm256_set1_epi8((char)filter_simd_data.counted_limits[l].second));
+        ymm_batch_pass_mask = _mm256_andnot_si256(_mm256_or_si256(ymm_too_few, ymm_too_many), ymm_batch_pass_mask);
+    }
+
+    return _mm256_movemask_epi8(ymm_batch_pass_mask);
+}
+
+template <int N>
+int BasicWordFilter<N>::hyperpacked_optimized_filterWordsCount(
     const unsigned char* hyperpacked_wordlist, 
     size_t words
-) {
-    if (!simd_data_initialized) {
-        this->filter_simd_data = SIMD_FilterData(*this);
-    }
-    // Assume SIMD_FilterData is already prepared (as in previous answer)
+) const {
+    typename BasicWordFilter<N>::SIMD_FilterData filter_simd_data;
+    filter_simd_data.build(this->constraints());
 
     int count = 0;
     const int BATCH_SIZE = 32;
-    std::array<__m256i, 5> ymm_word_char_cols;
+    std::array<__m256i, N> ymm_word_char_cols;
 
     size_t num_batches = (words + BATCH_SIZE - 1) / BATCH_SIZE;
 
     for (size_t batch_idx = 0; batch_idx < num_batches; ++batch_idx) {
-        size_t soa_batch_base_offset = batch_idx * 5 * BATCH_SIZE;
+        size_t soa_batch_base_offset = batch_idx * N * BATCH_SIZE;
 
         // 1. Load data for the current batch (MUCH FASTER NOW)
-        for (int j = 0; j < 5; ++j) {
+        unrolledFor<N>([&](auto j) {
             ymm_word_char_cols[j] = _mm256_load_si256(
                 reinterpret_cast<const __m256i*>(&hyperpacked_wordlist[soa_batch_base_offset + j * BATCH_SIZE])
             );
-        }
+        });
 
-        __m256i ymm_batch_pass_mask = filter_simd_data.ymm_all_ones;
+        unsigned int lanes_mask = filterBatchLanes<N>(filter_simd_data, ymm_word_char_cols);
+        if (lanes_mask == 0) continue;
 
-        // 2. Correct Letters (same logic as before)
-        for (int j = 0; j < 5; ++j) {
-            __m256i char_match = _mm256_cmpeq_epi8(ymm_word_char_cols[j], filter_simd_data.ymm_correct_chars[j]);
-            __m256i pass_this_char_correct = _mm256_or_si256(char_match, filter_simd_data.ymm_correct_is_space_mask[j]);
-            ymm_batch_pass_mask = _mm256_and_si256(ymm_batch_pass_mask, pass_this_char_correct);
+        // 5. Count results from the batch
+        // Correctly handle the last batch, which might be smaller than BATCH_SIZE
+        size_t words_in_this_batch_actual = BATCH_SIZE;
+        if (batch_idx == num_batches - 1) { // Last batch
+            words_in_this_batch_actual = words - (batch_idx * BATCH_SIZE);
         }
 
-        // OPTIMIZATION: Early exit if all words in batch failed
-        // _mm256_testz_si256(a, b) returns 1 if (a & b) is all zeros.
-        // We want to check if ymm_batch_pass_mask itself is all zeros.
-        // A common way: test ymm_batch_pass_mask against itself. If it's zero, (mask & mask) is zero.
-        // Or, more directly, compare its movemask to 0.
-        if (_mm256_movemask_epi8(ymm_batch_pass_mask) == 0) {
-            continue; // Skip to the next batch
+        if (words_in_this_batch_actual < BATCH_SIZE) {
+            lanes_mask &= (1U << words_in_this_batch_actual) - 1;
         }
+        count += _mm_popcnt_u32(lanes_mask);
+    }
 
-        // OPTIMIZATION: move up declarations to use goto statements
-        unsigned int lanes_mask;
-        size_t words_in_this_batch_actual = BATCH_SIZE;
+    return count;
+}
 
-        // 3. Misplaced Letters (same logic as before)
-        for (int j = 0; j < 5; ++j) {
-            if (filter_simd_data.ymm_misplaced_chars_bcast[j].empty()) continue;
-
-            for (const __m256i& ymm_m_bcast : filter_simd_data.ymm_misplaced_chars_bcast[j]) {
-                __m256i ymm_eq_at_j = _mm256_cmpeq_epi8(ymm_word_char_cols[j], ymm_m_bcast);
-                __m256i ymm_neq_at_j = _mm256_xor_si256(ymm_eq_at_j, filter_simd_data.ymm_all_ones);
-                __m256i ymm_present_in_word = _mm256_setzero_si256();
-                for (int k = 0; k < 5; ++k) {
-                    __m256i ymm_eq_at_k = _mm256_cmpeq_epi8(ymm_word_char_cols[k], ymm_m_bcast);
-                    ymm_present_in_word = _mm256_or_si256(ymm_present_in_word, ymm_eq_at_k);
-                }
-                __m256i ymm_misplaced_pass_for_m_at_j = _mm256_and_si256(ymm_neq_at_j, ymm_present_in_word);
-                ymm_batch_pass_mask = _mm256_and_si256(ymm_batch_pass_mask, ymm_misplaced_pass_for_m_at_j);
-            }
+// pshufb controls for compactBytesByMask, entry m moves the bytes of the set bits of m to the front
+struct CompactShuffleTable {
+    uint64_t controls[256];
+};
 
-            // OPTIMIZATION: Early exit after checking all misplaced for position j
-            if (_mm256_movemask_epi8(ymm_batch_pass_mask) == 0) {
-                goto next_batch_label; // Using goto to break out of nested loops
-            }
+// built at compile time: this file is compiled for AVX2, so no initializer of it may run before main
+// on hosts that fall back to the older kernels
+static constexpr CompactShuffleTable buildCompactShuffleTable() {
+    CompactShuffleTable table{};
+    for (int m = 0; m < 256; m++) {
+        uint64_t control = 0;
+        int out = 0;
+        for (int b = 0; b < 8; b++) {
+            if ((m >> b) & 1) control |= (uint64_t)b << (out++ * 8);
         }
+        table.controls[m] = control;
+    }
+    return table;
+}
+static constexpr CompactShuffleTable compactShuffleTable = buildCompactShuffleTable();
 
-        // 4. Wrong Letters (same logic as before)
-        for (const __m256i& ymm_w_bcast : filter_simd_data.ymm_wrong_chars_bcast) {
-            __m256i ymm_is_w_in_word = _mm256_setzero_si256();
-            for (int k = 0; k < 5; ++k) {
-                __m256i ymm_eq_at_k = _mm256_cmpeq_epi8(ymm_word_char_cols[k], ymm_w_bcast);
-                ymm_is_w_in_word = _mm256_or_si256(ymm_is_w_in_word, ymm_eq_at_k);
-            }
-            __m256i ymm_not_w_in_word = _mm256_xor_si256(ymm_is_w_in_word, filter_simd_data.ymm_all_ones);
-            ymm_batch_pass_mask = _mm256_and_si256(ymm_batch_pass_mask, ymm_not_w_in_word);
+size_t compactBytesByMask(const unsigned char* src, uint64_t mask, int lanes, unsigned char* dst) {
+    size_t count = 0;
+    for (int i = 0; i < lanes; i += 8) {
+        unsigned int m = (unsigned int)(mask >> i) & 0xFF;
+        __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&src[i]));
+        __m128i control = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&compactShuffleTable.controls[m]));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(&dst[count]), _mm_shuffle_epi8(bytes, control));
+        count += _mm_popcnt_u32(m);
+    }
+    return count;
+}
 
-            // OPTIMIZATION: Early exit after checking each wrong letter
-            if (_mm256_movemask_epi8(ymm_batch_pass_mask) == 0) {
-                goto next_batch_label;
-            }
-        }
+template <int N>
+size_t BasicWordFilter<N>::hyperpacked_filterCompact(
+    const unsigned char* hyperpacked_wordlist,
+    size_t words,
+    unsigned char* out
+) const {
+    typename BasicWordFilter<N>::SIMD_FilterData filter_simd_data;
+    filter_simd_data.build(this->constraints());
 
-        // 5. Count results from the batch
-        lanes_mask = _mm256_movemask_epi8(ymm_batch_pass_mask);
+    const int BATCH_SIZE = 32;
+    std::array<__m256i, N> ymm_word_char_cols;
+    //one compacted row per letter, with the slack compactBytesByMask needs
+    alignas(32) unsigned char rows[N][BATCH_SIZE + 8];
 
-        // Correctly handle the last batch, which might be smaller than BATCH_SIZE
-        // size_t words_in_this_batch_actual = BATCH_SIZE;
-        if (batch_idx == num_batches - 1) { // Last batch
-            words_in_this_batch_actual = words - (batch_idx * BATCH_SIZE);
-        }
+    size_t num_batches = (words + BATCH_SIZE - 1) / BATCH_SIZE;
+    std::memset(out, 0, (words / BATCH_SIZE + 1) * N * BATCH_SIZE);
 
-        if (words_in_this_batch_actual < BATCH_SIZE) {
-            lanes_mask &= (1U << words_in_this_batch_actual) - 1;
+    size_t count = 0;
+    for (size_t batch_idx = 0; batch_idx < num_batches; ++batch_idx) {
+        size_t soa_batch_base_offset = batch_idx * N * BATCH_SIZE;
+
+        unrolledFor<N>([&](auto j) {
+            ymm_word_char_cols[j] = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(&hyperpacked_wordlist[soa_batch_base_offset + j * BATCH_SIZE])
+            );
+        });
+
+        unsigned int lanes_mask = filterBatchLanes<N>(filter_simd_data, ymm_word_char_cols);
+        if (batch_idx == num_batches - 1 && words - batch_idx * BATCH_SIZE < BATCH_SIZE) {
+            lanes_mask &= (1U << (words - batch_idx * BATCH_SIZE)) - 1;
         }
-        count += _mm_popcnt_u32(lanes_mask);
+        if (lanes_mask == 0) continue;
 
-        next_batch_label:
-        __noop;
+        size_t passed = 0;
+        unrolledFor<N>([&](auto j) {
+            passed = compactBytesByMask(&hyperpacked_wordlist[soa_batch_base_offset + j * BATCH_SIZE], lanes_mask, BATCH_SIZE, rows[j]);
+        });
+        hyperpackedAppendRows(&rows[0][0], BATCH_SIZE + 8, N, passed, BATCH_SIZE, count, out);
+        count += passed;
     }
 
     return count;
-}
\ No newline at end of file
+}
+
+template <int N>
+void BasicWordFilter<N>::hyperpacked_blockFilterWordsCount(
+    const char* guess,
+    const char* solutions,
+    int solutionCount,
+    const unsigned char* hyperpacked_wordlist,
+    size_t words,
+    int* counts
+) {
+    // the three masks per position can't hold the count limits a repeated guess letter gives
+    if (hasRepeatedLetter(guess)) {
+        for (int s = 0; s < solutionCount; ++s) {
+            counts[s] = BasicWordFilter{ &solutions[s * N], guess }.hyperpacked_optimized_filterWordsCount(hyperpacked_wordlist, words);
+        }
+        return;
+    }
+
+    const int BATCH_SIZE = 32;
+
+    // every filter in the block is one of three masks per position, index of the one solution s keeps at position j
+    unsigned char keepIdx[filterBlockSize][N];
+    for (int s = 0; s < solutionCount; ++s) {
+        unsigned char states[N];
+        feedbackStates(&solutions[s * N], guess, states);
+        for (int j = 0; j < N; ++j) keepIdx[s][j] = (unsigned char)(j * 3 + states[j]);
+        counts[s] = 0;
+    }
+
+    std::array<__m256i, N> ymm_guess_chars_bcast;
+    for (int j = 0; j < N; ++j) ymm_guess_chars_bcast[j] = _mm256_set1_epi8(guess[j]);
+
+    std::array<__m256i, N> ymm_word_char_cols;
+    uint32_t keep[N * 3];
+
+    size_t num_batches = (words + BATCH_SIZE - 1) / BATCH_SIZE;
+
+    for (size_t batch_idx = 0; batch_idx < num_batches; ++batch_idx) {
+        size_t soa_batch_base_offset = batch_idx * N * BATCH_SIZE;
+
+        // 1. Load the batch once for the whole block
+        unrolledFor<N>([&](auto j) {
+            ymm_word_char_cols[j] = _mm256_load_si256(
+                reinterpret_cast<const __m256i*>(&hyperpacked_wordlist[soa_batch_base_offset + j * BATCH_SIZE])
+            );
+        });
+
+        // padding lanes would pass the wrong letter checks
+        size_t words_in_this_batch_actual = std::min<size_t>(BATCH_SIZE, words - batch_idx * BATCH_SIZE);
+        uint32_t lanes_valid = (words_in_this_batch_actual == BATCH_SIZE) ? ~0u : (1u << words_in_this_batch_actual) - 1;
+
+        // 2. Guess letter compares, shared by every filter: correct, misplaced and wrong mask per position
+        unrolledFor<N>([&](auto j) {
+            __m256i eq_at_j = _mm256_cmpeq_epi8(ymm_word_char_cols[j], ymm_guess_chars_bcast[j]);
+            __m256i present_in_word = _mm256_setzero_si256();
+            unrolledFor<N>([&](auto k) {
+                present_in_word = _mm256_or_si256(present_in_word, _mm256_cmpeq_epi8(ymm_word_char_cols[k], ymm_guess_chars_bcast[j]));
+            });
+
+            uint32_t eq_lanes = (uint32_t)_mm256_movemask_epi8(eq_at_j);
+            uint32_t present_lanes = (uint32_t)_mm256_movemask_epi8(present_in_word);
+            keep[j * 3 + 2] = eq_lanes & lanes_valid;
+            keep[j * 3 + 1] = ~eq_lanes & present_lanes & lanes_valid;
+            keep[j * 3 + 0] = ~present_lanes & lanes_valid;
+        });
+
+        // 3. Every filter of the block against the batch
+        for (int s = 0; s < solutionCount; ++s) {
+            uint32_t lanes_mask = keep[keepIdx[s][0]];
+            unrolledFor<N - 1>([&](auto j) {
+                lanes_mask &= keep[keepIdx[s][j + 1]];
+            });
+            counts[s] += _mm_popcnt_u32(lanes_mask);
+        }
+    }
+}
+
+template int BasicWordFilter<4>::hyperpacked_optimized_filterWordsCount(const unsigned char*, size_t) const;
+template int BasicWordFilter<5>::hyperpacked_optimized_filterWordsCount(const unsigned char*, size_t) const;
+template int BasicWordFilter<6>::hyperpacked_optimized_filterWordsCount(const unsigned char*, size_t) const;
+template int BasicWordFilter<7>::hyperpacked_optimized_filterWordsCount(const unsigned char*, size_t) const;
+
+template void BasicWordFilter<4>::hyperpacked_blockFilterWordsCount(const char*, const char*, int, const unsigned char*, size_t, int*);
+template void BasicWordFilter<5>::hyperpacked_blockFilterWordsCount(const char*, const char*, int, const unsigned char*, size_t, int*);
+template void BasicWordFilter<6>::hyperpacked_blockFilterWordsCount(const char*, const char*, int, const unsigned char*, size_t, int*);
+template void BasicWordFilter<7>::hyperpacked_blockFilterWordsCount(const char*, const char*, int, const unsigned char*, size_t, int*);
+
+template size_t BasicWordFilter<4>::hyperpacked_filterCompact(const unsigned char*, size_t, unsigned char*) const;
+template size_t BasicWordFilter<5>::hyperpacked_filterCompact(const unsigned char*, size_t, unsigned char*) const;
+template size_t BasicWordFilter<6>::hyperpacked_filterCompact(const unsigned char*, size_t, unsigned char*) const;
+template size_t BasicWordFilter<7>::hyperpacked_filterCompact(const unsigned char*, size_t, unsigned char*) const;
@@ -1,112 +1,153 @@
 #include "wordfilter.hpp"
+#include "cpufeatures.hpp"
 #include "words.h"
 
-int WordFilter::hyperpacked_optimized_filterWordsCount_AVX512(
-    const unsigned char* hyperpacked_wordlist,
-    size_t words
-) {
-    // Lazy initialization of AVX-512 specific filter data
-    if (!simd_data_avx512_initialized) {
-        this->filter_simd_data_avx512 = SIMD_FilterData_AVX512(*this);
-        this->simd_data_avx512_initialized = true;
-    }
-
-    int count = 0;
-    const int BATCH_SIZE_AVX512 = 64; // AVX-512 ZMM register processes 64 bytes
-    std::array<__m512i, 5> zmm_word_char_cols;
+#include <algorithm>
+#include <cstring>
 
-    size_t num_batches = (words + BATCH_SIZE_AVX512 - 1) / BATCH_SIZE_AVX512;
-
-    // __mmask64 k_all_ones = _mm512_kxnor(0, 0); // All 64 bits set in k-mask
-    // Alternative for k_all_ones, if needed explicitly for some ops, though often implicit (e.g. non-masked ops)
-    // Or more simply: if you start with a k-mask and AND results into it:
-    __mmask64 k_all_pass = (__mmask64)-1LL; // All 64 bits set
+template <int N>
+void BasicWordFilter<N>::SIMD_FilterData_AVX512::build(const BasicFilterConstraints<N>& constraints) {
+    unsatisfiable = constraints.unsatisfiable;
 
-    for (size_t batch_idx = 0; batch_idx < num_batches; ++batch_idx) {
-        size_t soa_batch_base_offset = batch_idx * 5 * BATCH_SIZE_AVX512;
+    zmm_correct_count = 0;
+    for (int j = 0; j < N; ++j) {
+        if (constraints.green[j] == ' ') continue;
+        zmm_correct_positions[zmm_correct_count] = j;
+        zmm_correct_chars[zmm_correct_count++] = _mm512_set1_epi8(constraints.green[j]);
+    }
 
-        // 1. Load data for the current batch
-        for (int j = 0; j < 5; ++j) {
-            // Use _mm512_loadu_si512 for unaligned loads, or _mm512_load_si512 if aligned
-            zmm_word_char_cols[j] = _mm512_loadu_si512(
-                reinterpret_cast<const void*>(&hyperpacked_wordlist[soa_batch_base_offset + j * BATCH_SIZE_AVX512])
-            );
+    for (int j = 0; j < N; ++j) {
+        zmm_forbidden_count[j] = 0;
+        for (int c = 0; c < BasicFilterConstraints<N>::letterCount; ++c) {
+            if ((constraints.forbidden[j] >> c) & 1) {
+                zmm_forbidden_chars_bcast[j][zmm_forbidden_count[j]++] = _mm512_set1_epi8('a' + c);
+            }
         }
+    }
 
-        __mmask64 k_batch_pass_mask = k_all_pass; // Start with all words in batch passing
-
-        // 2. Correct Letters
-        for (int j = 0; j < 5; ++j) {
-            // Compare word char with correct char, result is a k-mask
-            __mmask64 k_char_match = _mm512_cmpeq_epi8_mask(
-                zmm_word_char_cols[j],
-                filter_simd_data_avx512.zmm_correct_chars[j]
-            );
-            // Pass if (chars match) OR (filter's correct char for this position was a space)
-            __mmask64 k_pass_this_char_correct = _mm512_kor(
-                k_char_match,
-                filter_simd_data_avx512.k_correct_is_space[j] // Using precomputed k-mask
-            );
-            k_batch_pass_mask = _mm512_kand(k_batch_pass_mask, k_pass_this_char_correct);
+    uint32_t required = constraints.requiredLetters();
+    uint32_t absent = constraints.absentLetters();
+    uint32_t counted = constraints.countedLetters();
+    zmm_required_count = 0;
+    zmm_wrong_count = 0;
+    zmm_counted_count = 0;
+    for (int c = 0; c < BasicFilterConstraints<N>::letterCount; ++c) {
+        __m512i letter_bcast = _mm512_set1_epi8('a' + c);
+        if ((required >> c) & 1) zmm_required_chars_bcast[zmm_required_count++] = letter_bcast;
+        if ((absent >> c) & 1) zmm_wrong_chars_bcast[zmm_wrong_count++] = letter_bcast;
+        if ((counted >> c) & 1) {
+            counted_limits[zmm_counted_count] = { constraints.minCount[c], constraints.maxCount[c] };
+            zmm_counted_chars_bcast[zmm_counted_count++] = letter_bcast;
         }
+    }
+}
 
-        // OPTIMIZATION: Early exit if all words in batch failed
-        if (k_batch_pass_mask == 0) { // k-mask is 0 if no bits are set
-            continue;
-        }
+// steps 2-4 of the hyperpacked kernels, the lanes of one loaded batch that pass every constraint
+// padding lanes are not masked off here
+template <int N>
+static inline uint64_t filterBatchLanes_AVX512(const typename BasicWordFilter<N>::SIMD_FilterData_AVX512& filter_simd_data_avx512, const std::array<__m512i, N>& zmm_word_char_cols) {
+    if (filter_simd_data_avx512.unsatisfiable) return 0;
+    __mmask64 k_batch_pass_mask = (__mmask64)-1LL; // Start with all words in batch passing
 
-        // OPTIMIZATION: move up declarations for goto
-        uint64_t lanes_mask_u64; // For popcnt on 64-bit mask
-        size_t words_in_this_batch_actual = BATCH_SIZE_AVX512;
+    // 2. Correct Letters, free positions have nothing to compare
+    for (int g = 0; g < filter_simd_data_avx512.zmm_correct_count; ++g) {
+        __mmask64 k_char_match = _mm512_cmpeq_epi8_mask(
+            zmm_word_char_cols[filter_simd_data_avx512.zmm_correct_positions[g]],
+            filter_simd_data_avx512.zmm_correct_chars[g]
+        );
+        k_batch_pass_mask = _kand_mask64(k_batch_pass_mask, k_char_match);
+    }
 
+    // OPTIMIZATION: Early exit if all words in batch failed
+    if (k_batch_pass_mask == 0) { // k-mask is 0 if no bits are set
+        return 0;
+    }
 
-        // 3. Misplaced Letters
-        for (int j = 0; j < 5; ++j) {
-            if (filter_simd_data_avx512.zmm_misplaced_chars_bcast[j].empty()) continue;
+    // 3. Misplaced Letters: the letters each position can't hold, one compare each
+    for (int j = 0; j < N; ++j) {
+        for (int m = 0; m < filter_simd_data_avx512.zmm_forbidden_count[j]; ++m) {
+            // passing lanes only, a compare under a mask leaves the failed ones failed
+            k_batch_pass_mask = _mm512_mask_cmpneq_epi8_mask(k_batch_pass_mask, zmm_word_char_cols[j], filter_simd_data_avx512.zmm_forbidden_chars_bcast[j][m]);
+        }
+    }
 
-            for (const __m512i& zmm_m_bcast : filter_simd_data_avx512.zmm_misplaced_chars_bcast[j]) {
-                // Cond1: char m NOT at word[j]
-                __mmask64 k_eq_at_j = _mm512_cmpeq_epi8_mask(zmm_word_char_cols[j], zmm_m_bcast);
-                __mmask64 k_neq_at_j = _mm512_knot(k_eq_at_j); // k_neq_at_j = _mm512_kxor(k_eq_at_j, k_all_pass);
+    // then every letter that must be somewhere, once
+    for (int m = 0; m < filter_simd_data_avx512.zmm_required_count; ++m) {
+        const __m512i& zmm_m_bcast = filter_simd_data_avx512.zmm_required_chars_bcast[m];
+        __mmask64 k_present_in_word = 0; // Start with no bits set
+        unrolledFor<N>([&](auto k) {
+            __mmask64 k_eq_at_k = _mm512_cmpeq_epi8_mask(zmm_word_char_cols[k], zmm_m_bcast);
+            k_present_in_word = _kor_mask64(k_present_in_word, k_eq_at_k);
+        });
+        k_batch_pass_mask = _kand_mask64(k_batch_pass_mask, k_present_in_word);
+    }
 
-                // Cond2: char m MUST be present somewhere
-                __mmask64 k_present_in_word = 0; // Start with no bits set
-                for (int k = 0; k < 5; ++k) {
-                    __mmask64 k_eq_at_k = _mm512_cmpeq_epi8_mask(zmm_word_char_cols[k], zmm_m_bcast);
-                    k_present_in_word = _mm512_kor(k_present_in_word, k_eq_at_k);
-                }
+    if (k_batch_pass_mask == 0) {
+        return 0;
+    }
 
-                __mmask64 k_misplaced_pass_for_m_at_j = _mm512_kand(k_neq_at_j, k_present_in_word);
-                k_batch_pass_mask = _mm512_kand(k_batch_pass_mask, k_misplaced_pass_for_m_at_j);
-            }
+    // 4. Wrong Letters
+    if (filter_simd_data_avx512.zmm_wrong_count != 0) { // Check if there are any wrong letters to process
+        for (int w = 0; w < filter_simd_data_avx512.zmm_wrong_count; ++w) {
+            const __m512i& zmm_w_bcast = filter_simd_data_avx512.zmm_wrong_chars_bcast[w];
+            __mmask64 k_is_w_in_word = 0; // Start with no bits set
+            unrolledFor<N>([&](auto k) {
+                __mmask64 k_eq_at_k = _mm512_cmpeq_epi8_mask(zmm_word_char_cols[k], zmm_w_bcast);
+                k_is_w_in_word = _kor_mask64(k_is_w_in_word, k_eq_at_k);
+            });
+            __mmask64 k_not_w_in_word = _knot_mask64(k_is_w_in_word);
+            k_batch_pass_mask = _kand_mask64(k_batch_pass_mask, k_not_w_in_word);
 
             if (k_batch_pass_mask == 0) {
-                goto next_batch_label_avx512;
+                return 0;
             }
         }
+    }
 
-        // 4. Wrong Letters
-        if (!filter_simd_data_avx512.zmm_wrong_chars_bcast.empty()) { // Check if there are any wrong letters to process
-            for (const __m512i& zmm_w_bcast : filter_simd_data_avx512.zmm_wrong_chars_bcast) {
-                __mmask64 k_is_w_in_word = 0; // Start with no bits set
-                for (int k = 0; k < 5; ++k) {
-                    __mmask64 k_eq_at_k = _mm512_cmpeq_epi8_mask(zmm_word_char_cols[k], zmm_w_bcast);
-                    k_is_w_in_word = _mm512_kor(k_is_w_in_word, k_eq_at_k);
-                }
-                __mmask64 k_not_w_in_word = _mm512_knot(k_is_w_in_word);
-                k_batch_pass_mask = _mm512_kand(k_batch_pass_mask, k_not_w_in_word);
-
-                if (k_batch_pass_mask == 0) {
-                    goto next_batch_label_avx512;
-                }
-            }
-        }
+    // 5. Letter counts, cmpeq lanes are -1 so subtracting them counts up
+    for (int l = 0; l < filter_simd_data_avx512.zmm_counted_count; ++l) {
+        const __m512i& zmm_l_bcast = filter_simd_data_avx512.zmm_counted_chars_bcast[l];
+        __m512i zmm_count = _mm512_setzero_si512();
+        unrolledFor<N>([&](auto k) {
+            zmm_count = _mm512_sub_epi8(zmm_count, _mm512_movm_epi8(_mm512_cmpeq_epi8_mask(zmm_word_char_cols[k], zmm_l_bcast)));
+        });
+        k_batch_pass_mask = _mm512_mask_cmpge_epu8_mask(k_batch_pass_mask, zmm_count, _mm512_set1_epi8((char)filter_simd_data_avx512.counted_limits[l].first));
+        k_batch_pass_mask = _mm512_mask_cmple_epu8_mask(k_batch_pass_mask, zmm_count, _mm512_set1_epi8((char)filter_simd_data_avx512.counted_limits[l].second));
+    }
 
+    return k_batch_pass_mask;
+}
 
-        // 5. Count results from the batch
-        // k_batch_pass_mask is already the 64-bit integer we need for popcount.
-        lanes_mask_u64 = k_batch_pass_mask;
+template <int N>
+int BasicWordFilter<N>::hyperpacked_optimized_filterWordsCount_AVX512(
+    const unsigned char* hyperpacked_wordlist,
+    size_t words
+) const {
+    typename BasicWordFilter<N>::SIMD_FilterData_AVX512 filter_simd_data_avx512;
+    filter_simd_data_avx512.build(this->constraints());
+
+    int count = 0;
+    const int BATCH_SIZE_AVX512 = 64; // AVX-512 ZMM register processes 64 bytes
+    std::array<__m512i, N> zmm_word_char_cols;
+
+    size_t num_batches = (words + BATCH_SIZE_AVX512 - 1) / BATCH_SIZE_AVX512;
 
+    for (size_t batch_idx = 0; batch_idx < num_batches; ++batch_idx) {
+        size_t soa_batch_base_offset = batch_idx * N * BATCH_SIZE_AVX512;
+
+        // 1. Load data for the current batch
+        unrolledFor<N>([&](auto j) {
+            // Use _mm512_loadu_si512 for unaligned loads, or _mm512_load_si512 if aligned
+            zmm_word_char_cols[j] = _mm512_loadu_si512(
+                reinterpret_cast<const void*>(&hyperpacked_wordlist[soa_batch_base_offset + j * BATCH_SIZE_AVX512])
+            );
+        });
+
+        uint64_t lanes_mask_u64 = filterBatchLanes_AVX512<N>(filter_simd_data_avx512, zmm_word_char_cols);
+        if (lanes_mask_u64 == 0) continue;
+
+        // 5. Count results from the batch
+        size_t words_in_this_batch_actual = BATCH_SIZE_AVX512;
         if (batch_idx == num_batches - 1) {
             words_in_this_batch_actual = words - (batch_idx * BATCH_SIZE_AVX512);
         }
@@ -121,11 +162,165 @@ int WordFilter::hyperpacked_optimized_filterWordsCount_AVX512(
 #else // GCC/Clang
         count += _popcnt64(lanes_mask_u64); // or __builtin_popcountll(lanes_mask_u64)
 #endif
+    }
+
+    return count;
+}
+
+//vpcompressb is AVX-512 VBMI2 (Ice Lake on), older AVX-512 parts compact through the shuffle table
+//detected on first use, this file is compiled for AVX-512 so none of it may run before main
+static bool hasCompressBytes() {
+    static const bool supported = detectCpuFeatures().avx512vbmi2;
+    return supported;
+}
+
+template <int N>
+size_t BasicWordFilter<N>::hyperpacked_filterCompact_AVX512(
+    const unsigned char* hyperpacked_wordlist,
+    size_t words,
+    unsigned char* out
+) const {
+    typename BasicWordFilter<N>::SIMD_FilterData_AVX512 filter_simd_data_avx512;
+    filter_simd_data_avx512.build(this->constraints());
+
+    const bool compressBytes = hasCompressBytes();
+    const int BATCH_SIZE_AVX512 = 64;
+    std::array<__m512i, N> zmm_word_char_cols;
+    //one compacted row per letter, with the slack compactBytesByMask needs
+    //the stride is 72 bytes, so only rows[0] is 64 byte aligned and the stores into rows are unaligned ones
+    alignas(64) unsigned char rows[N][BATCH_SIZE_AVX512 + 8];
+
+    size_t num_batches = (words + BATCH_SIZE_AVX512 - 1) / BATCH_SIZE_AVX512;
+    std::memset(out, 0, (words / BATCH_SIZE_AVX512 + 1) * N * BATCH_SIZE_AVX512);
+
+    size_t count = 0;
+    for (size_t batch_idx = 0; batch_idx < num_batches; ++batch_idx) {
+        size_t soa_batch_base_offset = batch_idx * N * BATCH_SIZE_AVX512;
+
+        unrolledFor<N>([&](auto j) {
+            zmm_word_char_cols[j] = _mm512_loadu_si512(
+                reinterpret_cast<const void*>(&hyperpacked_wordlist[soa_batch_base_offset + j * BATCH_SIZE_AVX512])
+            );
+        });
 
+        uint64_t lanes_mask_u64 = filterBatchLanes_AVX512<N>(filter_simd_data_avx512, zmm_word_char_cols);
+        if (batch_idx == num_batches - 1 && words - batch_idx * BATCH_SIZE_AVX512 < BATCH_SIZE_AVX512) {
+            lanes_mask_u64 &= (1ULL << (words - batch_idx * BATCH_SIZE_AVX512)) - 1;
+        }
+        if (lanes_mask_u64 == 0) continue;
 
-    next_batch_label_avx512:;
-        // __noop; // MSVC specific, not needed for GCC/Clang if label is used
+        size_t passed = 0;
+        if (compressBytes) {
+            unrolledFor<N>([&](auto j) {
+                _mm512_storeu_si512(rows[j], _mm512_maskz_compress_epi8(lanes_mask_u64, zmm_word_char_cols[j]));
+            });
+#ifdef _MSC_VER
+            passed = __popcnt64(lanes_mask_u64);
+#else // GCC/Clang
+            passed = _popcnt64(lanes_mask_u64);
+#endif
+        }
+        else {
+            unrolledFor<N>([&](auto j) {
+                passed = compactBytesByMask(&hyperpacked_wordlist[soa_batch_base_offset + j * BATCH_SIZE_AVX512], lanes_mask_u64, BATCH_SIZE_AVX512, rows[j]);
+            });
+        }
+        hyperpackedAppendRows(&rows[0][0], BATCH_SIZE_AVX512 + 8, N, passed, BATCH_SIZE_AVX512, count, out);
+        count += passed;
     }
 
     return count;
-}
\ No newline at end of file
+}
+
+template <int N>
+void BasicWordFilter<N>::hyperpacked_blockFilterWordsCount_AVX512(
+    const char* guess,
+    const char* solutions,
+    int solutionCount,
+    const unsigned char* hyperpacked_wordlist,
+    size_t words,
+    int* counts
+) {
+    // the three masks per position can't hold the count limits a repeated guess letter gives
+    if (hasRepeatedLetter(guess)) {
+        for (int s = 0; s < solutionCount; ++s) {
+            counts[s] = BasicWordFilter{ &solutions[s * N], guess }.hyperpacked_optimized_filterWordsCount_AVX512(hyperpacked_wordlist, words);
+        }
+        return;
+    }
+
+    const int BATCH_SIZE_AVX512 = 64;
+
+    // every filter in the block is one of three masks per position, index of the one solution s keeps at position j
+    unsigned char keepIdx[filterBlockSize][N];
+    for (int s = 0; s < solutionCount; ++s) {
+        unsigned char states[N];
+        feedbackStates(&solutions[s * N], guess, states);
+        for (int j = 0; j < N; ++j) keepIdx[s][j] = (unsigned char)(j * 3 + states[j]);
+        counts[s] = 0;
+    }
+
+    std::array<__m512i, N> zmm_guess_chars_bcast;
+    for (int j = 0; j < N; ++j) zmm_guess_chars_bcast[j] = _mm512_set1_epi8(guess[j]);
+
+    std::array<__m512i, N> zmm_word_char_cols;
+    uint64_t keep[N * 3];
+
+    size_t num_batches = (words + BATCH_SIZE_AVX512 - 1) / BATCH_SIZE_AVX512;
+
+    for (size_t batch_idx = 0; batch_idx < num_batches; ++batch_idx) {
+        size_t soa_batch_base_offset = batch_idx * N * BATCH_SIZE_AVX512;
+
+        // 1. Load the batch once for the whole block
+        unrolledFor<N>([&](auto j) {
+            zmm_word_char_cols[j] = _mm512_loadu_si512(
+                reinterpret_cast<const void*>(&hyperpacked_wordlist[soa_batch_base_offset + j * BATCH_SIZE_AVX512])
+            );
+        });
+
+        // padding lanes would pass the wrong letter checks
+        size_t words_in_this_batch_actual = std::min<size_t>(BATCH_SIZE_AVX512, words - batch_idx * BATCH_SIZE_AVX512);
+        uint64_t k_valid = (words_in_this_batch_actual == BATCH_SIZE_AVX512) ? ~0ULL : (1ULL << words_in_this_batch_actual) - 1;
+
+        // 2. Guess letter compares, shared by every filter: correct, misplaced and wrong mask per position
+        unrolledFor<N>([&](auto j) {
+            __mmask64 k_eq_at_j = _mm512_cmpeq_epi8_mask(zmm_word_char_cols[j], zmm_guess_chars_bcast[j]);
+            __mmask64 k_present_in_word = 0;
+            unrolledFor<N>([&](auto k) {
+                k_present_in_word = _kor_mask64(k_present_in_word, _mm512_cmpeq_epi8_mask(zmm_word_char_cols[k], zmm_guess_chars_bcast[j]));
+            });
+
+            keep[j * 3 + 2] = k_eq_at_j & k_valid;
+            keep[j * 3 + 1] = ~k_eq_at_j & k_present_in_word & k_valid;
+            keep[j * 3 + 0] = ~k_present_in_word & k_valid;
+        });
+
+        // 3. Every filter of the block against the batch
+        for (int s = 0; s < solutionCount; ++s) {
+            uint64_t lanes_mask_u64 = keep[keepIdx[s][0]];
+            unrolledFor<N - 1>([&](auto j) {
+                lanes_mask_u64 &= keep[keepIdx[s][j + 1]];
+            });
+#ifdef _MSC_VER
+            counts[s] += (int)__popcnt64(lanes_mask_u64);
+#else // GCC/Clang
+            counts[s] += (int)_popcnt64(lanes_mask_u64);
+#endif
+        }
+    }
+}
+
+template int BasicWordFilter<4>::hyperpacked_optimized_filterWordsCount_AVX512(const unsigned char*, size_t) const;
+template int BasicWordFilter<5>::hyperpacked_optimized_filterWordsCount_AVX512(const unsigned char*, size_t) const;
+template int BasicWordFilter<6>::hyperpacked_optimized_filterWordsCount_AVX512(const unsigned char*, size_t) const;
+template int BasicWordFilter<7>::hyperpacked_optimized_filterWordsCount_AVX512(const unsigned char*, size_t) const;
+
+template void BasicWordFilter<4>::hyperpacked_blockFilterWordsCount_AVX512(const char*, const char*, int, const unsigned char*, size_t, int*);
+template void BasicWordFilter<5>::hyperpacked_blockFilterWordsCount_AVX512(const char*, const char*, int, const unsigned char*, size_t, int*);
+template void BasicWordFilter<6>::hyperpacked_blockFilterWordsCount_AVX512(const char*, const char*, int, const unsigned char*, size_t, int*);
+template void BasicWordFilter<7>::hyperpacked_blockFilterWordsCount_AVX512(const char*, const char*, int, const unsigned char*, size_t, int*);
+
+template size_t BasicWordFilter<4>::hyperpacked_filterCompact_AVX512(const unsigned char*, size_t, unsigned char*) const;
+template size_t BasicWordFilter<5>::hyperpacked_filterCompact_AVX512(const unsigned char*, size_t, unsigned char*) const;
+template size_t BasicWordFilter<6>::hyperpacked_filterCompact_AVX512(const unsigned char*, size_t, unsigned char*) const;
+template size_t BasicWordFilter<7>::hyperpacked_filterCompact_AVX512(const unsigned char*, size_t, unsigned char*) const;
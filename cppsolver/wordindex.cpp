@@ -0,0 +1,133 @@
+#include "wordindex.hpp"
+#include "words.h"
+
+#include <cstring>
+
+size_t wordIndexIntersect(const uint64_t* const* andSets, int andCount, const uint64_t* const* andNotSets, int andNotCount, size_t blocks, uint64_t* result) {
+    size_t count = 0;
+    for (size_t b = 0; b < blocks; b++) {
+        uint64_t bits = andSets[0][b];
+        for (int i = 1; i < andCount; i++) bits &= andSets[i][b];
+        for (int i = 0; i < andNotCount; i++) bits &= ~andNotSets[i][b];
+
+        if (result != nullptr) result[b] = bits;
+        count += portablePopcount(bits);
+    }
+    return count;
+}
+
+template <int N>
+void BasicWordIndex<N>::AlignedFree::operator()(uint64_t* mem) const {
+    _aligned_free(mem);
+}
+
+static inline int letterSlot(char c) {
+    return (c >= 'a' && c <= 'z') ? c - 'a' : -1;
+}
+
+template <int N>
+BasicWordIndex<N>::BasicWordIndex(const std::vector<std::string>& wordlist, SimdLevel simdLevel) {
+    this->simdLevel = simdLevel;
+    this->words = wordlist.size();
+    //whole zmm registers, and never empty so the sets always have an address
+    this->blocks = ((this->words + 511) / 512 + 1) * 8;
+
+    size_t setCount = N * letterCount + letterCount + 1;
+    size_t bytes = setCount * this->blocks * sizeof(uint64_t);
+    this->sets.reset((uint64_t*)_aligned_malloc(bytes, 64));
+    std::memset(this->sets.get(), 0, bytes);
+
+    for (size_t i = 0; i < this->words; i++) {
+        size_t block = i / 64;
+        uint64_t bit = 1ull << (i % 64);
+        this->allWordsSet()[block] |= bit;
+
+        for (int j = 0; j < N; j++) {
+            int letter = letterSlot(wordlist[i][j]);
+            if (letter < 0) continue;
+            this->positionSet(j, letter)[block] |= bit;
+            this->containsSet(letter)[block] |= bit;
+        }
+    }
+}
+
+template <int N>
+size_t BasicWordIndex<N>::filterBits(const BasicWordFilter<N>& filter, uint64_t* bits) const {
+    return this->filterBits(filter.constraints(), bits);
+}
+
+template <int N>
+size_t BasicWordIndex<N>::filterBits(const BasicFilterConstraints<N>& constraints, uint64_t* bits) const {
+    if (constraints.unsatisfiable) {
+        if (bits != nullptr) std::memset(bits, 0, this->blocks * sizeof(uint64_t));
+        return 0;
+    }
+
+    //at most N + 26 sets to AND and 26 * N + 26 to ANDNOT
+    const uint64_t* andSets[N + letterCount + 1];
+    const uint64_t* andNotSets[N * letterCount + letterCount];
+    int andCount = 0;
+    int andNotCount = 0;
+
+    andSets[andCount++] = this->allWordsSet();
+    for (int j = 0; j < N; j++) {
+        if (constraints.green[j] != ' ') andSets[andCount++] = this->positionSet(j, constraints.green[j] - 'a');
+        for (uint32_t m = constraints.forbidden[j]; m != 0; m &= m - 1) andNotSets[andNotCount++] = this->positionSet(j, lowestSetBit(m));
+    }
+    for (uint32_t m = constraints.requiredLetters(); m != 0; m &= m - 1) andSets[andCount++] = this->containsSet(lowestSetBit(m));
+    for (uint32_t m = constraints.absentLetters(); m != 0; m &= m - 1) andNotSets[andNotCount++] = this->containsSet(lowestSetBit(m));
+
+    uint32_t counted = constraints.countedLetters();
+    std::unique_ptr<uint64_t[], AlignedFree> scratch;
+    if (counted != 0 && bits == nullptr) {
+        //the counts below need the intersection itself
+        scratch.reset((uint64_t*)_aligned_malloc(this->blocks * sizeof(uint64_t), 64));
+        bits = scratch.get();
+    }
+
+    size_t count = (this->simdLevel == SimdLevel::AVX512)
+        ? wordIndexIntersect_AVX512(andSets, andCount, andNotSets, andNotCount, this->blocks, bits)
+        : wordIndexIntersect(andSets, andCount, andNotSets, andNotCount, this->blocks, bits);
+    if (counted == 0) return count;
+
+    //letter counts aren't one set, atLeast[k] is built up position by position from the position sets
+    count = 0;
+    for (size_t b = 0; b < this->blocks; b++) {
+        for (uint32_t m = counted; m != 0 && bits[b] != 0; m &= m - 1) {
+            int letter = lowestSetBit(m);
+            uint64_t atLeast[N + 2] = { ~0ull };
+            for (int j = 0; j < N; j++) {
+                uint64_t here = this->positionSet(j, letter)[b];
+                for (int k = j + 1; k >= 1; k--) atLeast[k] |= atLeast[k - 1] & here;
+            }
+            bits[b] &= atLeast[constraints.minCount[letter]] & ~atLeast[constraints.maxCount[letter] + 1];
+        }
+        count += portablePopcount(bits[b]);
+    }
+    return count;
+}
+
+template <int N>
+size_t BasicWordIndex<N>::filterWordsCount(const BasicWordFilter<N>& filter) const {
+    return this->filterBits(filter, nullptr);
+}
+
+template <int N>
+std::vector<int> BasicWordIndex<N>::filterIndexes(const BasicWordFilter<N>& filter) const {
+    std::unique_ptr<uint64_t[], AlignedFree> bits{ (uint64_t*)_aligned_malloc(this->blocks * sizeof(uint64_t), 64) };
+    size_t count = this->filterBits(filter, bits.get());
+
+    std::vector<int> idxs;
+    idxs.reserve(count);
+    for (size_t b = 0; b < this->blocks; b++) {
+        for (uint64_t m = bits[b]; m != 0; m &= m - 1) {
+            idxs.push_back((int)(b * 64 + lowestSetBit(m)));
+        }
+    }
+    return idxs;
+}
+
+template class BasicWordIndex<4>;
+template class BasicWordIndex<5>;
+template class BasicWordIndex<6>;
+template class BasicWordIndex<7>;
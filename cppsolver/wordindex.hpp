@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+
+#include "cpufeatures.hpp"
+#include "wordfilter.hpp"
+
+//bit i of each block run is word i of the list, blocks are padded to a multiple of 8 (one zmm) with zero bits
+//result gets blocks words, may be nullptr when only the count is needed, returns the number of set bits
+//result = andSets[0] & ... & andSets[andCount - 1] & ~andNotSets[0] & ... & ~andNotSets[andNotCount - 1]
+//andCount must be at least 1
+size_t wordIndexIntersect(const uint64_t* const* andSets, int andCount, const uint64_t* const* andNotSets, int andNotCount, size_t blocks, uint64_t* result);
+//same, sets and result 64 byte aligned
+size_t wordIndexIntersect_AVX512(const uint64_t* const* andSets, int andCount, const uint64_t* const* andNotSets, int andNotCount, size_t blocks, uint64_t* result);
+
+//inverted index of a word list: one bitset per (position, letter), one per contained letter
+//any BasicWordFilter<N> then becomes a few AND / ANDNOT passes over n / 64 words plus a popcount,
+//instead of testing every word letter by letter
+//built once per dictionary, read only afterwards so any number of threads can query it
+//letters outside a-z never match, the same as the filters treat them
+template <int N>
+class BasicWordIndex {
+public:
+    static constexpr int letterCount = 26;
+
+    BasicWordIndex(const std::vector<std::string>& wordlist, SimdLevel simdLevel);
+
+    BasicWordIndex(const BasicWordIndex&) = delete;
+    BasicWordIndex& operator=(const BasicWordIndex&) = delete;
+
+    size_t size() const { return this->words; }
+    size_t getBlockCount() const { return this->blocks; }
+
+    //same count as filter.filterWordsCount(wordlist)
+    size_t filterWordsCount(const BasicWordFilter<N>& filter) const;
+    //indexes into the word list of the words filter.filterWords(wordlist) keeps, in list order
+    std::vector<int> filterIndexes(const BasicWordFilter<N>& filter) const;
+    //bit i set if word i passes, bits must hold getBlockCount() words (64 byte aligned for AVX-512)
+    size_t filterBits(const BasicWordFilter<N>& filter, uint64_t* bits) const;
+    //same from the normalized form, what the filter overloads read
+    size_t filterBits(const BasicFilterConstraints<N>& constraints, uint64_t* bits) const;
+
+private:
+    struct AlignedFree {
+        void operator()(uint64_t* mem) const;
+    };
+
+    uint64_t* positionSet(int position, int letter) const { return &(this->sets[(position * letterCount + letter) * this->blocks]); }
+    uint64_t* containsSet(int letter) const { return &(this->sets[(N * letterCount + letter) * this->blocks]); }
+    uint64_t* allWordsSet() const { return &(this->sets[(N * letterCount + letterCount) * this->blocks]); }
+
+    size_t words = 0;
+    size_t blocks = 0;
+    SimdLevel simdLevel;
+    //N * 26 position sets, 26 contains sets, then one with every word, blocks words each
+    std::unique_ptr<uint64_t[], AlignedFree> sets;
+};
+
+using WordIndex = BasicWordIndex<5>;
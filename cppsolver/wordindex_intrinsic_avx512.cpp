@@ -0,0 +1,24 @@
+#include "wordindex.hpp"
+#include "words.h"
+
+size_t wordIndexIntersect_AVX512(const uint64_t* const* andSets, int andCount, const uint64_t* const* andNotSets, int andNotCount, size_t blocks, uint64_t* result) {
+    size_t count = 0;
+    alignas(64) uint64_t lanes[8];
+
+    //512 words per step, every set is read once per step so all of them stream together
+    for (size_t b = 0; b < blocks; b += 8) {
+        __m512i zmm_bits = _mm512_load_si512(&(andSets[0][b]));
+        for (int i = 1; i < andCount; i++) {
+            zmm_bits = _mm512_and_si512(zmm_bits, _mm512_load_si512(&(andSets[i][b])));
+        }
+        for (int i = 0; i < andNotCount; i++) {
+            zmm_bits = _mm512_andnot_si512(_mm512_load_si512(&(andNotSets[i][b])), zmm_bits);
+        }
+
+        //vpopcntq needs AVX512_VPOPCNTDQ, which AVX512BW hosts don't all have
+        _mm512_store_si512(lanes, zmm_bits);
+        if (result != nullptr) _mm512_store_si512(&(result[b]), zmm_bits);
+        for (int i = 0; i < 8; i++) count += _mm_popcnt_u64(lanes[i]);
+    }
+    return count;
+}
@@ -0,0 +1,249 @@
+#include "wordlistfile.hpp"
+#include "words.h"
+
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+void WordlistFile::AlignedFree::operator()(unsigned char* mem) const {
+    _aligned_free(mem);
+}
+
+//read only view of a whole file, unmapped when it goes out of scope
+class MappedWordFile {
+public:
+    ~MappedWordFile() {
+#ifdef _WIN32
+        if (this->view != nullptr) UnmapViewOfFile(this->view);
+        if (this->mapping != nullptr) CloseHandle(this->mapping);
+        if (this->file != INVALID_HANDLE_VALUE) CloseHandle(this->file);
+#else
+        if (this->view != nullptr) munmap((void*)this->view, this->size);
+#endif
+    }
+
+    bool open(const std::string& path) {
+#ifdef _WIN32
+        this->file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (this->file == INVALID_HANDLE_VALUE) return false;
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(this->file, &fileSize)) return false;
+        this->size = (size_t)fileSize.QuadPart;
+        if (this->size == 0) return true;
+
+        this->mapping = CreateFileMappingA(this->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (this->mapping == nullptr) return false;
+        this->view = (const unsigned char*)MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0);
+        return this->view != nullptr;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            return false;
+        }
+        this->size = (size_t)st.st_size;
+        if (this->size == 0) {
+            close(fd);
+            return true;
+        }
+
+        void* mapped = mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd); //the mapping keeps the file alive
+        if (mapped == MAP_FAILED) return false;
+
+        //read once front to back
+        madvise(mapped, this->size, MADV_SEQUENTIAL);
+        this->view = (const unsigned char*)mapped;
+        return true;
+#endif
+    }
+
+    const unsigned char* view = nullptr;
+    size_t size = 0;
+
+private:
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+};
+
+//writes each word into the flat and both hyperpacked tables as it is parsed
+struct WordTableWriter {
+    unsigned char* flat;
+    unsigned char* hyperpacked32;
+    unsigned char* hyperpacked64;
+    size_t count = 0;
+
+    //false if word isn't 5 letters
+    bool push(const unsigned char* word, size_t length) {
+        if (length != 5) return false;
+
+        unsigned char* flatWord = &(this->flat[this->count * 5]);
+        for (int j = 0; j < 5; j++) {
+            unsigned char c = word[j];
+            if (c >= 'A' && c <= 'Z') c = c - 'A' + 'a';
+            if (c < 'a' || c > 'z') return false;
+            flatWord[j] = c;
+        }
+
+        unsigned char* lane32 = &(this->hyperpacked32[(this->count / 32) * 32 * 5 + (this->count % 32)]);
+        unsigned char* lane64 = &(this->hyperpacked64[(this->count / 64) * 64 * 5 + (this->count % 64)]);
+        for (int j = 0; j < 5; j++) {
+            lane32[j * 32] = flatWord[j];
+            lane64[j * 64] = flatWord[j];
+        }
+
+        this->count++;
+        return true;
+    }
+};
+
+static inline bool isSpace(unsigned char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static std::string describeWord(size_t number, const unsigned char* word, size_t length) {
+    return "word " + std::to_string(number) + " \"" + std::string((const char*)word, length < 16 ? length : 16) + "\" is not 5 letters";
+}
+
+//["aahed", "aalii", ...]
+static bool parseJsonWords(const unsigned char* p, const unsigned char* end, WordTableWriter& writer, std::string& error) {
+    p++; //[
+    while (p < end && isSpace(*p)) p++;
+    if (p < end && *p == ']') {
+        p++;
+    }
+    else {
+        while (true) {
+            if (p >= end || *p != '"') {
+                error = "expected a string after word " + std::to_string(writer.count);
+                return false;
+            }
+            const unsigned char* word = ++p;
+            while (p < end && *p != '"') p++;
+            if (p >= end) {
+                error = "unterminated string after word " + std::to_string(writer.count);
+                return false;
+            }
+            if (!writer.push(word, p - word)) {
+                error = describeWord(writer.count + 1, word, p - word);
+                return false;
+            }
+            p++; //"
+
+            while (p < end && isSpace(*p)) p++;
+            if (p < end && *p == ',') {
+                p++;
+                while (p < end && isSpace(*p)) p++;
+                continue;
+            }
+            if (p < end && *p == ']') {
+                p++;
+                break;
+            }
+            error = "expected , or ] after word " + std::to_string(writer.count);
+            return false;
+        }
+    }
+
+    while (p < end && isSpace(*p)) p++;
+    if (p != end) {
+        error = "unexpected data after the closing ]";
+        return false;
+    }
+    return true;
+}
+
+//one word per line, blank lines and surrounding spaces are ignored
+static bool parseLineWords(const unsigned char* p, const unsigned char* end, WordTableWriter& writer, std::string& error) {
+    while (p < end) {
+        const unsigned char* lineEnd = (const unsigned char*)std::memchr(p, '\n', end - p);
+        if (lineEnd == nullptr) lineEnd = end;
+
+        const unsigned char* word = p;
+        const unsigned char* wordEnd = lineEnd;
+        while (word < wordEnd && isSpace(*word)) word++;
+        while (wordEnd > word && isSpace(wordEnd[-1])) wordEnd--;
+
+        if (word != wordEnd && !writer.push(word, wordEnd - word)) {
+            error = describeWord(writer.count + 1, word, wordEnd - word);
+            return false;
+        }
+
+        p = lineEnd + (lineEnd < end ? 1 : 0);
+    }
+    return true;
+}
+
+bool WordlistFile::load(const std::string& path, std::string& error) {
+    if (this->flatBuffer != nullptr) {
+        error = "a word list can only be loaded once";
+        return false;
+    }
+
+    MappedWordFile file;
+    if (!file.open(path)) {
+        error = "could not open " + path;
+        return false;
+    }
+
+    const unsigned char* p = file.view;
+    const unsigned char* end = file.view + file.size;
+    //utf-8 byte order mark
+    if (end - p >= 3 && p[0] == 0xEF && p[1] == 0xBB && p[2] == 0xBF) p += 3;
+    while (p < end && isSpace(*p)) p++;
+
+    //every word takes at least 6 bytes of the file (5 letters and a separator) except the last,
+    //so the tables can be sized once up front and filled in the same pass that validates
+    size_t maxWords = file.size / 6 + 1;
+    size_t hyperpacked32Bytes = (maxWords / 32 + 1) * 32 * 5;
+    size_t hyperpacked64Bytes = (maxWords / 64 + 1) * 64 * 5;
+
+    TableBuffer flat{ (unsigned char*)_aligned_malloc(maxWords * 5, 64) };
+    TableBuffer hyperpacked32{ (unsigned char*)_aligned_malloc(hyperpacked32Bytes, 64) };
+    TableBuffer hyperpacked64{ (unsigned char*)_aligned_malloc(hyperpacked64Bytes, 64) };
+    if (flat == nullptr || hyperpacked32 == nullptr || hyperpacked64 == nullptr) {
+        error = "out of memory loading " + path;
+        return false;
+    }
+
+    WordTableWriter writer{ flat.get(), hyperpacked32.get(), hyperpacked64.get() };
+    bool parsed = (p < end && *p == '[') ? parseJsonWords(p, end, writer, error) : parseLineWords(p, end, writer, error);
+    if (!parsed) {
+        error = path + ": " + error;
+        return false;
+    }
+
+    //zero the unused lanes of the last batch, padding lanes must read as 0
+    size_t words = writer.count;
+    unsigned char* tails[2] = { hyperpacked32.get(), hyperpacked64.get() };
+    int packwidths[2] = { 32, 64 };
+    for (int t = 0; t < 2; t++) {
+        int packwidth = packwidths[t];
+        unsigned char* lastBatch = &(tails[t][(words / packwidth) * packwidth * 5]);
+        size_t usedLanes = words % packwidth;
+        for (int j = 0; j < 5; j++) {
+            std::memset(&(lastBatch[j * packwidth + usedLanes]), 0, packwidth - usedLanes);
+        }
+    }
+
+    this->flatBuffer = std::move(flat);
+    this->hyperpacked32Buffer = std::move(hyperpacked32);
+    this->hyperpacked64Buffer = std::move(hyperpacked64);
+    this->setTables(this->flatBuffer.get(), words, this->hyperpacked32Buffer.get(), this->hyperpacked64Buffer.get());
+    return true;
+}
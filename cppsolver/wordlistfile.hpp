@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <memory>
+
+#include "packedwords.hpp"
+
+// dictionary loaded at runtime, either the Words.txt / ValidWords.txt json array of strings
+// or one word per line
+// the file is memory mapped and transcoded straight into the flat and hyperpacked tables in one pass,
+// no std::string is made unless strings() is called
+class WordlistFile : public PackedWordTables {
+public:
+    WordlistFile() = default;
+
+    // false with a reason in error if the file can't be read or holds anything but 5 letter words
+    // letters are lower cased
+    bool load(const std::string& path, std::string& error);
+
+private:
+    struct AlignedFree {
+        void operator()(unsigned char* mem) const;
+    };
+    using TableBuffer = std::unique_ptr<unsigned char[], AlignedFree>;
+
+    TableBuffer flatBuffer;
+    TableBuffer hyperpacked32Buffer;
+    TableBuffer hyperpacked64Buffer;
+};
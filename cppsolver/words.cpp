@@ -0,0 +1,12 @@
+#include "words.h"
+
+#include <iterator>
+
+//packed at compile time, the tables go straight into read only data
+static constexpr auto allWordsHyperpacked32 = hyperpackWords<32>(allWordsFlat);
+static constexpr auto allWordsHyperpacked64 = hyperpackWords<64>(allWordsFlat);
+static constexpr auto validWordsHyperpacked32 = hyperpackWords<32>(validWordsFlat);
+static constexpr auto validWordsHyperpacked64 = hyperpackWords<64>(validWordsFlat);
+
+const PackedWordTables allWords{ (const unsigned char*)allWordsFlat, std::size(allWordsFlat), allWordsHyperpacked32.data, allWordsHyperpacked64.data };
+const PackedWordTables validWords{ (const unsigned char*)validWordsFlat, std::size(validWordsFlat), validWordsHyperpacked32.data, validWordsHyperpacked64.data };
@@ -1,4 +1,9 @@
 #pragma once
 
 #include "allwords.hpp"
-#include "validwords.hpp"
\ No newline at end of file
+#include "validwords.hpp"
+
+// the dictionaries compiled into the binary, every packed form lives in read only data
+// so nothing is built before main and the kernels can read the tables in place
+extern const PackedWordTables allWords;
+extern const PackedWordTables validWords;